@@ -5,6 +5,8 @@
  */
 
 #include <Arduino.h>
+#include <BenchLoopMarker.h>
+#include <SegmentStrip.h>
 
 constexpr uint8_t kSegmentPins[] = {2, 3, 4, 5,
                                     6, 7, 8, 9}; // a, b, c, d, e, f, g, dp
@@ -25,11 +27,7 @@ enum Segment : uint8_t {
   SEG_DP = 0b10000000,
 };
 
-struct Glyph {
-  char symbol;
-  uint8_t mask;
-};
-
+// Compile-time glyph source for kTestPatterns; never read at runtime.
 constexpr Glyph kGlyphs[] = {
     {'0', SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F},
     {'1', SEG_B | SEG_C},
@@ -52,18 +50,17 @@ constexpr Glyph kGlyphs[] = {
     {' ', 0},
 };
 
-const char *kTestPatterns[] = {
-    "0123", "4567", "89Ab", "CdEF", "----", "....", "    ",
-};
+constexpr size_t kGlyphCount = sizeof(kGlyphs) / sizeof(kGlyphs[0]);
 
-uint8_t glyphFor(char symbol) {
-  for (const auto &glyph : kGlyphs) {
-    if (glyph.symbol == symbol) {
-      return glyph.mask;
-    }
-  }
-  return 0;
-}
+typedef GlyphFont<kGlyphCount, kGlyphs> TesterFont;
+
+constexpr size_t kPatternLength = 4;
+constexpr SegmentStrip<kPatternLength> kTestPatterns[] PROGMEM = {
+    bakeSegments<TesterFont>("0123"), bakeSegments<TesterFont>("4567"),
+    bakeSegments<TesterFont>("89Ab"), bakeSegments<TesterFont>("CdEF"),
+    bakeSegments<TesterFont>("----"), bakeSegments<TesterFont>("...."),
+    bakeSegments<TesterFont>("    "),
+};
 
 constexpr uint8_t segmentOnLevel() { return kCommonAnode ? LOW : HIGH; }
 
@@ -86,12 +83,17 @@ void enableDigit(size_t index, bool enable) {
                enable ? digitEnableLevel() : digitDisableLevel());
 }
 
-void displayFrame(const char *text, uint32_t durationMillis) {
+// pattern lives in PROGMEM and is already encoded.
+void displayFrame(const SegmentStrip<kPatternLength> &pattern,
+                  uint32_t durationMillis) {
+  uint8_t masks[kPatternLength];
+  memcpy_P(masks, pattern.cells, kPatternLength);
+
   const uint32_t start = millis();
   do {
     for (size_t digit = 0; digit < 4; ++digit) {
       enableDigit(digit, false);
-      writeSegments(glyphFor(text[digit]));
+      writeSegments(masks[digit]);
       enableDigit(digit, true);
       delayMicroseconds(kFrameDelayMicros);
       enableDigit(digit, false);
@@ -116,6 +118,7 @@ void sweepSegments() {
 }
 
 void setup() {
+  BENCH_LOOP_SETUP();
   for (const auto pin : kSegmentPins) {
     pinMode(pin, OUTPUT);
     digitalWrite(pin, segmentOffLevel());
@@ -127,9 +130,10 @@ void setup() {
 }
 
 void loop() {
+  BENCH_LOOP_MARK();
   sweepSegments(); // confirm every segment lights
 
-  for (const auto *pattern : kTestPatterns) {
+  for (const auto &pattern : kTestPatterns) {
     displayFrame(pattern, kHoldMillis);
   }
 }
@@ -1,4 +1,5 @@
 #include <Arduino.h>
+#include <BenchLoopMarker.h>
 
 namespace {
 constexpr uint8_t SEGMENT_COUNT = 7;
@@ -17,10 +18,10 @@ constexpr uint8_t SEG_F = 1 << 5;
 constexpr uint8_t SEG_G = 1 << 6;
 
 constexpr unsigned long COUNT_INTERVAL_MS = 20;
-constexpr unsigned long FLIP_FRAME_DURATION_MS[] = {150, 110, 150};
+constexpr unsigned long FLIP_FRAME_DURATION_MS[] PROGMEM = {150, 110, 150};
 constexpr unsigned int MULTIPLEX_ON_TIME_US = 1000;
 
-constexpr uint8_t normalDigitPatterns[10] = {
+constexpr uint8_t normalDigitPatterns[10] PROGMEM = {
     SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,         // 0
     SEG_B | SEG_C,                                         // 1
     SEG_A | SEG_B | SEG_D | SEG_E | SEG_G,                 // 2
@@ -40,7 +41,7 @@ constexpr uint8_t rotateSegments(uint8_t pattern) {
          ((pattern & SEG_G) ? SEG_G : 0);
 }
 
-constexpr uint8_t invertedDigitPatterns[10] = {
+constexpr uint8_t invertedDigitPatterns[10] PROGMEM = {
     rotateSegments(normalDigitPatterns[0]),
     rotateSegments(normalDigitPatterns[1]),
     rotateSegments(normalDigitPatterns[2]),
@@ -62,8 +63,8 @@ unsigned long lastUpdateMs = 0;
 
 uint8_t activePatterns[DIGIT_COUNT] = {0, 0, 0, 0};
 
-constexpr uint8_t NORMAL_DIGIT_ORDER[DIGIT_COUNT] = {0, 1, 2, 3};
-constexpr uint8_t INVERTED_DIGIT_ORDER[DIGIT_COUNT] = {3, 2, 1, 0};
+constexpr uint8_t NORMAL_DIGIT_ORDER[DIGIT_COUNT] PROGMEM = {0, 1, 2, 3};
+constexpr uint8_t INVERTED_DIGIT_ORDER[DIGIT_COUNT] PROGMEM = {3, 2, 1, 0};
 
 uint8_t animationFrame = 0;
 unsigned long animationFrameStartMs = 0;
@@ -73,7 +74,8 @@ uint8_t patternForDigit(uint8_t digit, bool inverted) {
   if (digit > 9) {
     return 0;
   }
-  return inverted ? invertedDigitPatterns[digit] : normalDigitPatterns[digit];
+  return pgm_read_byte(inverted ? &invertedDigitPatterns[digit]
+                                : &normalDigitPatterns[digit]);
 }
 
 void setUniformPattern(uint8_t pattern) {
@@ -105,7 +107,8 @@ void setPatternsForValue(int value, bool inverted) {
       continue;
     }
     leadingZero = false;
-    activePatterns[digitOrder[position]] = patternForDigit(digit, inverted);
+    activePatterns[pgm_read_byte(&digitOrder[position])] =
+        patternForDigit(digit, inverted);
   }
 }
 
@@ -140,7 +143,7 @@ void updateFlipAnimation(unsigned long now) {
   }
 
   const unsigned long elapsed = now - animationFrameStartMs;
-  if (elapsed < FLIP_FRAME_DURATION_MS[animationFrame]) {
+  if (elapsed < pgm_read_dword(&FLIP_FRAME_DURATION_MS[animationFrame])) {
     return;
   }
 
@@ -179,6 +182,7 @@ void refreshDisplay() {
 } // namespace
 
 void setup() {
+  BENCH_LOOP_SETUP();
   for (uint8_t pin : segmentPins) {
     pinMode(pin, OUTPUT);
     digitalWrite(pin, HIGH);
@@ -194,6 +198,7 @@ void setup() {
 }
 
 void loop() {
+  BENCH_LOOP_MARK();
   refreshDisplay();
 
   const unsigned long now = millis();
@@ -1,4 +1,6 @@
 #include <Arduino.h>
+#include <BenchLoopMarker.h>
+#include <SegmentStrip.h>
 #include <ctype.h>
 #include <string.h>
 
@@ -18,21 +20,31 @@ constexpr size_t kDisplayDigits = sizeof(kDigitPins) / sizeof(kDigitPins[0]);
 constexpr size_t kPaddingSpaces =
     kDisplayDigits;                          // Leading and trailing blanks
 constexpr size_t kMaxMessageLength = 64;     // Adjust if you need longer text
-constexpr size_t kMaxPaddedLength =
-    kMaxMessageLength + 2 * kPaddingSpaces;
+static_assert(kMaxMessageLength <= 255, "strip lengths are stored in a byte");
 
-constexpr char kDefaultMessage[] = "HELLO 7SEG";
+constexpr char kStatusQuery = '?'; // A line holding only this reports RAM use
+constexpr uint8_t kStackPaint = 0xC5;
+
+#ifdef __AVR__
+extern uint8_t __heap_start;
+extern uint8_t __stack;
+extern void *__brkval;
+#endif
 
 uint8_t gDisplayBuffer[kDisplayDigits] = {};
 char gMessage[kMaxMessageLength + 1] = {};
 size_t gMessageLength = 0;
-char gPaddedMessage[kMaxPaddedLength + 1] = {};
-size_t gPaddedLength = 0;
+uint8_t gMessageSegments[kMaxMessageLength] = {}; // gMessage, encoded
+SegmentStripView gStrip = {gMessageSegments, 0, 0, 0,
+                           0, 0, false}; // Scrolled cells
+size_t gPaddedLength = 0; // gStrip plus kPaddingSpaces blanks on each side
 size_t gScrollIndex = 0;
 size_t gScrollLimit = 1;
 size_t gCurrentDigit = kDisplayDigits - 1;
 unsigned long gLastRefreshMicros = 0;
 unsigned long gLastScrollMillis = 0;
+unsigned long gDigitOnMicros = kDigitRefreshIntervalMicros; // Brightness duty
+bool gDigitLit = false;
 
 char gSerialInputBuffer[kMaxMessageLength + 1] = {};
 size_t gSerialInputLength = 0;
@@ -41,12 +53,134 @@ int gScrollDirection = 1; // 1: right-to-left, -1: left-to-right
 enum class PingPongState : uint8_t { None, AwaitingBounce };
 
 PingPongState gPingPongState = PingPongState::None;
-constexpr char kPingCommand[] = "PING";
-constexpr char kPongResponse[] = "PONG";
+constexpr char kPingCommand[] PROGMEM = "PING";
 constexpr size_t kPingCommandLength = sizeof(kPingCommand) - 1;
-constexpr size_t kPongResponseLength = sizeof(kPongResponse) - 1;
+
+// Per-message scroll behaviour, selected by a "~<tag>" prefix on the serial
+// line (e.g. "~B HELLO"). Untagged messages wrap.
+enum class MarqueeMode : uint8_t {
+  Wrap,         // ~W: scroll through and start over
+  Bounce,       // ~B: reverse whenever the text reaches either display edge
+  BounceOnce,   // ~O: reverse at the far edge, then leave the way it came
+  ScrollInHold, // ~H: scroll in and stop once aligned
+  BlinkHold,    // ~K: scroll in, stop once aligned and blink
+};
+
+struct MarqueeTag {
+  char tag;
+  MarqueeMode mode;
+};
+
+constexpr char kMarqueePrefix = '~';
+constexpr MarqueeTag kMarqueeTags[] PROGMEM = {
+    {'W', MarqueeMode::Wrap},         {'B', MarqueeMode::Bounce},
+    {'O', MarqueeMode::BounceOnce},   {'H', MarqueeMode::ScrollInHold},
+    {'K', MarqueeMode::BlinkHold},
+};
+
+MarqueeMode gMarqueeMode = MarqueeMode::Wrap;
+bool gMarqueeBounced = false;
+bool gBlinkVisible = true;
+
+// Visible-edge metadata precomputed by updateVisibleEdges(). The window
+// range runs from the first to the last scroll index showing a visible cell;
+// the blank range, empty unless gStrip's widest gap is at least a display
+// wide, holds the indices inside it that show nothing. Narrower gaps never
+// blank a window. Only the widest gap is tracked, which covers the one gap a
+// ping command can hold. The aligned range spans the indices where the text
+// touches a display edge.
+bool gHasVisibleChars = false;
+size_t gFirstVisibleWindow = 0;
+size_t gLastVisibleWindow = 0;
+size_t gBlankWindowStart = 0;
+size_t gBlankWindowEnd = 0;
+size_t gAlignedLowIndex = 0;
+size_t gAlignedHighIndex = 0;
+size_t gLeftAlignedIndex = 0;
+
+// Effect between consecutive messages, selected by a "^<tag>" prefix (e.g.
+// "^W HELLO", combinable with a marquee tag). Effects render one step every
+// kTransitionFramesPerStep scan frames from the old and new encoded windows.
+enum class TransitionEffect : uint8_t {
+  Cut,      // ^C: switch instantly and scroll the new text in
+  Wipe,     // ^W: new window replaces the old digit by digit
+  Dissolve, // ^D: segments flip to the new window in scattered order
+  PushUp,   // ^U: old glyphs slide up and out, new ones rise from below
+  DashFlip, // ^F: blank, dashes, then the new window
+};
+
+struct TransitionTag {
+  char tag;
+  TransitionEffect effect;
+};
+
+constexpr char kTransitionPrefix = '^';
+constexpr TransitionTag kTransitionTags[] PROGMEM = {
+    {'C', TransitionEffect::Cut},      {'W', TransitionEffect::Wipe},
+    {'D', TransitionEffect::Dissolve}, {'U', TransitionEffect::PushUp},
+    {'F', TransitionEffect::DashFlip},
+};
+
+constexpr uint8_t kTransitionFramesPerStep = 4; // ~32 ms per effect step
+constexpr size_t kDissolveCells = kDisplayDigits * 7;
+constexpr size_t kDissolveCellsPerStep = 4;
+constexpr size_t kDissolveStride = 23; // Scatters the segment order
+
+constexpr size_t greatestCommonDivisor(size_t a, size_t b) {
+  return (b == 0) ? a : greatestCommonDivisor(b, a % b);
+}
+static_assert(greatestCommonDivisor(kDissolveCells, kDissolveStride) == 1,
+              "dissolve stride must visit every segment exactly once");
+
+TransitionEffect gTransitionEffect = TransitionEffect::Cut; // Cut: idle
+uint8_t gTransitionFrom[kDisplayDigits] = {};
+uint8_t gTransitionTo[kDisplayDigits] = {};
+uint8_t gTransitionStep = 0;
+uint8_t gTransitionFrame = 0;
+size_t gDissolveCursor = 0;
+
+// Binary streaming: a 0x00 byte switches the serial parser into framed mode.
+// Each packet is COBS-encoded and terminated by 0x00. Decoded layout:
+// [opcode][sequence][payload...][crc lo][crc hi], CRC-16/CCITT-FALSE over
+// everything before the CRC. Every packet is answered with an ACK or NAK
+// echoing its sequence number; framing error NAKs carry sequence 0 and hosts
+// must not match them to a pending packet.
+enum class SerialMode : uint8_t { Text, Binary };
+enum class FrameOpcode : uint8_t {
+  SegmentFrame = 0x01, // payload: one segment byte per digit
+  Brightness = 0x02,   // payload: duty cycle 0-255
+  ResumeScroll = 0x03, // payload: none, hand the display back to the text
+  ExitBinary = 0x04,   // payload: none, resume scrolling and text input
+  Ack = 0x80,
+  Nak = 0x81,
+};
+enum class FrameStatus : uint8_t {
+  Ok = 0,
+  BadCrc = 1,
+  BadLength = 2,
+  BadOpcode = 3,
+  Overflow = 4,    // Framing error, not tied to a packet
+  BadEncoding = 5, // Framing error: bad COBS or too short to hold a CRC
+};
+
+constexpr uint8_t kFrameDelimiter = 0x00;
+constexpr size_t kFrameHeaderLength = 2; // opcode + sequence
+constexpr size_t kFrameCrcLength = 2;
+constexpr size_t kMaxFramePayload = kDisplayDigits;
+constexpr size_t kMaxFrameLength =
+    kFrameHeaderLength + kMaxFramePayload + kFrameCrcLength;
+constexpr size_t kMaxEncodedFrameLength = kMaxFrameLength + 1; // < 254 bytes
+
+SerialMode gSerialMode = SerialMode::Text;
+uint8_t gEncodedFrame[kMaxEncodedFrameLength] = {};
+size_t gEncodedFrameLength = 0;
+bool gEncodedFrameOverflow = false;
+bool gFrameStreamActive = false; // Host owns gDisplayBuffer, scrolling paused
+bool gHaveFrameSequence = false;
+uint8_t gLastFrameSequence = 0;
 
 void setMessage(const char *message, size_t length);
+void showStrip(const SegmentStripView &strip);
 
 constexpr uint8_t SEG_A = 1 << 0;
 constexpr uint8_t SEG_B = 1 << 1;
@@ -56,73 +190,62 @@ constexpr uint8_t SEG_E = 1 << 4;
 constexpr uint8_t SEG_F = 1 << 5;
 constexpr uint8_t SEG_G = 1 << 6;
 
-constexpr uint8_t kDigitPatterns[10] = {
-    SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,         // 0
-    SEG_B | SEG_C,                                         // 1
-    SEG_A | SEG_B | SEG_D | SEG_E | SEG_G,                 // 2
-    SEG_A | SEG_B | SEG_C | SEG_D | SEG_G,                 // 3
-    SEG_B | SEG_C | SEG_F | SEG_G,                         // 4
-    SEG_A | SEG_C | SEG_D | SEG_F | SEG_G,                 // 5
-    SEG_A | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G,         // 6
-    SEG_A | SEG_B | SEG_C,                                 // 7
-    SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G, // 8
-    SEG_A | SEG_B | SEG_C | SEG_D | SEG_F | SEG_G          // 9
+// Compile-time glyph source for kAsciiSegments and baked strips; never read
+// at runtime. Letters are upper case, lower case input is folded onto them.
+constexpr Glyph kGlyphTable[] = {
+    {'0', SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F},
+    {'1', SEG_B | SEG_C},
+    {'2', SEG_A | SEG_B | SEG_D | SEG_E | SEG_G},
+    {'3', SEG_A | SEG_B | SEG_C | SEG_D | SEG_G},
+    {'4', SEG_B | SEG_C | SEG_F | SEG_G},
+    {'5', SEG_A | SEG_C | SEG_D | SEG_F | SEG_G},
+    {'6', SEG_A | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G},
+    {'7', SEG_A | SEG_B | SEG_C},
+    {'8', SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G},
+    {'9', SEG_A | SEG_B | SEG_C | SEG_D | SEG_F | SEG_G},
+    {'A', SEG_A | SEG_B | SEG_C | SEG_E | SEG_F | SEG_G},
+    {'B', SEG_C | SEG_D | SEG_E | SEG_F | SEG_G},
+    {'C', SEG_A | SEG_D | SEG_E | SEG_F},
+    {'D', SEG_B | SEG_C | SEG_D | SEG_E | SEG_G},
+    {'E', SEG_A | SEG_D | SEG_E | SEG_F | SEG_G},
+    {'F', SEG_A | SEG_E | SEG_F | SEG_G},
+    {'G', SEG_A | SEG_C | SEG_D | SEG_E | SEG_F},
+    {'H', SEG_B | SEG_C | SEG_E | SEG_F | SEG_G},
+    {'I', SEG_B | SEG_C},
+    {'J', SEG_B | SEG_C | SEG_D},
+    {'L', SEG_D | SEG_E | SEG_F},
+    {'N', SEG_C | SEG_E | SEG_G},
+    {'O', SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F},
+    {'P', SEG_A | SEG_B | SEG_E | SEG_F | SEG_G},
+    {'R', SEG_A | SEG_B | SEG_E | SEG_F | SEG_G | SEG_C},
+    {'S', SEG_A | SEG_C | SEG_D | SEG_F | SEG_G},
+    {'T', SEG_D | SEG_E | SEG_F | SEG_G},
+    {'U', SEG_B | SEG_C | SEG_D | SEG_E | SEG_F},
+    {'Y', SEG_B | SEG_C | SEG_D | SEG_F | SEG_G},
+    {'-', SEG_G},
+    {'_', SEG_D},
 };
+constexpr size_t kAsciiCount = 128;
 
-uint8_t encodeChar(char c) {
-  if (c >= '0' && c <= '9') {
-    return kDigitPatterns[c - '0'];
-  }
-
-  c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
-
-  switch (c) {
-  case 'A':
-    return SEG_A | SEG_B | SEG_C | SEG_E | SEG_F | SEG_G;
-  case 'B':
-    return SEG_C | SEG_D | SEG_E | SEG_F | SEG_G;
-  case 'C':
-    return SEG_A | SEG_D | SEG_E | SEG_F;
-  case 'D':
-    return SEG_B | SEG_C | SEG_D | SEG_E | SEG_G;
-  case 'E':
-    return SEG_A | SEG_D | SEG_E | SEG_F | SEG_G;
-  case 'F':
-    return SEG_A | SEG_E | SEG_F | SEG_G;
-  case 'G':
-    return SEG_A | SEG_C | SEG_D | SEG_E | SEG_F;
-  case 'H':
-    return SEG_B | SEG_C | SEG_E | SEG_F | SEG_G;
-  case 'I':
-    return SEG_B | SEG_C;
-  case 'J':
-    return SEG_B | SEG_C | SEG_D;
-  case 'L':
-    return SEG_D | SEG_E | SEG_F;
-  case 'N':
-    return SEG_C | SEG_E | SEG_G;
-  case 'O':
-    return SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F;
-  case 'P':
-    return SEG_A | SEG_B | SEG_E | SEG_F | SEG_G;
-  case 'R':
-    return SEG_A | SEG_B | SEG_E | SEG_F | SEG_G | SEG_C;
-  case 'S':
-    return SEG_A | SEG_C | SEG_D | SEG_F | SEG_G;
-  case 'T':
-    return SEG_D | SEG_E | SEG_F | SEG_G;
-  case 'U':
-    return SEG_B | SEG_C | SEG_D | SEG_E | SEG_F;
-  case 'Y':
-    return SEG_B | SEG_C | SEG_D | SEG_F | SEG_G;
-  case '-':
-    return SEG_G;
-  case '_':
-    return SEG_D;
-  case ' ':
-  default:
-    return 0;
+constexpr char upperCase(char c) {
+  return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+struct DisplayFont {
+  static constexpr uint8_t segments(char c) {
+    return glyphLookup(kGlyphTable, upperCase(c));
   }
+};
+
+constexpr SegmentTable<kAsciiCount> kAsciiSegments PROGMEM =
+    bakeSegmentTable<DisplayFont, kAsciiCount>();
+
+constexpr auto kDefaultBanner PROGMEM = bakeSegments<DisplayFont>("HELLO 7SEG");
+constexpr auto kPongBanner PROGMEM = bakeSegments<DisplayFont>("PONG");
+
+uint8_t encodeChar(char c) {
+  const unsigned char code = static_cast<unsigned char>(c);
+  return (code < kAsciiCount) ? pgm_read_byte(&kAsciiSegments.cells[code]) : 0;
 }
 
 uint8_t segmentOnState(bool segmentEnabled) {
@@ -148,77 +271,221 @@ void disableAllDigits() {
   }
 }
 
+constexpr uint8_t shiftSegmentsUp(uint8_t pattern) {
+  return ((pattern & SEG_G) ? SEG_A : 0) | ((pattern & SEG_C) ? SEG_B : 0) |
+         ((pattern & SEG_E) ? SEG_F : 0) | ((pattern & SEG_D) ? SEG_G : 0);
+}
+
+constexpr uint8_t shiftSegmentsDown(uint8_t pattern) {
+  return ((pattern & SEG_A) ? SEG_G : 0) | ((pattern & SEG_B) ? SEG_C : 0) |
+         ((pattern & SEG_F) ? SEG_E : 0) | ((pattern & SEG_G) ? SEG_D : 0);
+}
+
+// Renders gTransitionStep into gDisplayBuffer. Returns false once the effect
+// has no steps left.
+bool renderTransitionStep() {
+  switch (gTransitionEffect) {
+  case TransitionEffect::Wipe:
+    if (gTransitionStep > kDisplayDigits) {
+      return false;
+    }
+    for (size_t digit = 0; digit < kDisplayDigits; ++digit) {
+      gDisplayBuffer[digit] = (digit < gTransitionStep)
+                                  ? gTransitionTo[digit]
+                                  : gTransitionFrom[digit];
+    }
+    return true;
+  case TransitionEffect::Dissolve:
+    if (gDissolveCursor >= kDissolveCells) {
+      return false;
+    }
+    for (size_t i = 0; i < kDissolveCellsPerStep; ++i) {
+      if (gDissolveCursor >= kDissolveCells) {
+        break;
+      }
+      const size_t cell =
+          (gDissolveCursor++ * kDissolveStride) % kDissolveCells;
+      const size_t digit = cell / 7;
+      const uint8_t mask = static_cast<uint8_t>(1 << (cell % 7));
+      gDisplayBuffer[digit] = static_cast<uint8_t>(
+          (gDisplayBuffer[digit] & ~mask) | (gTransitionTo[digit] & mask));
+    }
+    return true;
+  case TransitionEffect::PushUp:
+    if (gTransitionStep > 2) {
+      return false;
+    }
+    for (size_t digit = 0; digit < kDisplayDigits; ++digit) {
+      const uint8_t from = gTransitionFrom[digit];
+      const uint8_t to = gTransitionTo[digit];
+      // Each step moves both glyphs up by half a digit.
+      gDisplayBuffer[digit] =
+          (gTransitionStep == 1)
+              ? (shiftSegmentsUp(from) |
+                 shiftSegmentsDown(shiftSegmentsDown(to)))
+              : (shiftSegmentsUp(shiftSegmentsUp(from)) |
+                 shiftSegmentsDown(to));
+    }
+    return true;
+  case TransitionEffect::DashFlip:
+    if (gTransitionStep > 2) {
+      return false;
+    }
+    memset(gDisplayBuffer, (gTransitionStep == 1) ? 0 : SEG_G,
+           sizeof(gDisplayBuffer));
+    return true;
+  case TransitionEffect::Cut:
+    break;
+  }
+
+  return false;
+}
+
+void finishTransition() {
+  memcpy(gDisplayBuffer, gTransitionTo, sizeof(gDisplayBuffer));
+  gTransitionEffect = TransitionEffect::Cut;
+  gLastScrollMillis = millis();
+}
+
+// Called once per scan frame; costs at most one effect step.
+void advanceTransition() {
+  if (gTransitionEffect == TransitionEffect::Cut) {
+    return;
+  }
+
+  if (++gTransitionFrame < kTransitionFramesPerStep) {
+    return;
+  }
+  gTransitionFrame = 0;
+  ++gTransitionStep;
+
+  if (!renderTransitionStep()) {
+    finishTransition();
+  }
+}
+
 void refreshDisplay() {
   digitalWrite(kDigitPins[gCurrentDigit], digitState(false));
 
   gCurrentDigit = (gCurrentDigit + 1) % kDisplayDigits;
+  if (gCurrentDigit == 0) {
+    advanceTransition();
+  }
   applySegments(gDisplayBuffer[gCurrentDigit]);
-  digitalWrite(kDigitPins[gCurrentDigit], digitState(true));
+  gDigitLit = gDigitOnMicros > 0;
+  if (gDigitLit) {
+    digitalWrite(kDigitPins[gCurrentDigit], digitState(true));
+  }
 }
 
-void updateScrollBuffer() {
-  for (size_t digit = 0; digit < kDisplayDigits; ++digit) {
-    const size_t charIndex = gScrollIndex + digit;
-    const char c =
-        (charIndex < gPaddedLength) ? gPaddedMessage[charIndex] : ' ';
-    gDisplayBuffer[digit] = encodeChar(c);
+void dimDisplay(unsigned long nowMicros) {
+  if (!gDigitLit || gDigitOnMicros >= kDigitRefreshIntervalMicros) {
+    return;
+  }
+
+  if (nowMicros - gLastRefreshMicros >= gDigitOnMicros) {
+    digitalWrite(kDigitPins[gCurrentDigit], digitState(false));
+    gDigitLit = false;
   }
 }
 
-void buildPaddedMessage() {
-  const size_t totalLength = gMessageLength + 2 * kPaddingSpaces;
-  gPaddedLength =
-      (totalLength <= kMaxPaddedLength) ? totalLength : kMaxPaddedLength;
+void setBrightness(uint8_t level) {
+  gDigitOnMicros = (kDigitRefreshIntervalMicros * level) / 255;
+}
 
-  size_t writeIndex = 0;
-  const size_t leadingSpaces =
-      (kPaddingSpaces <= gPaddedLength) ? kPaddingSpaces : gPaddedLength;
-  for (size_t i = 0; i < leadingSpaces; ++i) {
-    gPaddedMessage[writeIndex++] = ' ';
+void updateScrollBuffer() {
+  for (size_t digit = 0; digit < kDisplayDigits; ++digit) {
+    const size_t cellIndex = gScrollIndex + digit;
+    gDisplayBuffer[digit] =
+        (cellIndex >= kPaddingSpaces &&
+         cellIndex - kPaddingSpaces < gStrip.length)
+            ? stripCell(gStrip, cellIndex - kPaddingSpaces)
+            : 0;
   }
+}
 
-  const size_t remainingCapacity =
-      (gPaddedLength > writeIndex) ? (gPaddedLength - writeIndex) : 0;
-  size_t copyLength =
-      (gMessageLength < remainingCapacity) ? gMessageLength : remainingCapacity;
-  if (copyLength > 0) {
-    memcpy(&gPaddedMessage[writeIndex], gMessage, copyLength);
-    writeIndex += copyLength;
-  }
+size_t clampScrollIndex(size_t index) {
+  return (index < gScrollLimit) ? index : gScrollLimit - 1;
+}
 
-  while (writeIndex < gPaddedLength) {
-    gPaddedMessage[writeIndex++] = ' ';
+// Derives the edge metadata from gStrip's visible range in O(1).
+void updateVisibleEdges() {
+  gHasVisibleChars = gStrip.firstVisible < gStrip.length;
+  if (!gHasVisibleChars) {
+    gFirstVisibleWindow = gLastVisibleWindow = 0;
+    gBlankWindowStart = gBlankWindowEnd = 0;
+    gAlignedLowIndex = gAlignedHighIndex = gLeftAlignedIndex = 0;
+    return;
   }
 
-  gPaddedMessage[writeIndex] = '\0';
+  const size_t firstCell = kPaddingSpaces + gStrip.firstVisible;
+  const size_t lastCell = kPaddingSpaces + gStrip.lastVisible;
+  gFirstVisibleWindow = clampScrollIndex(
+      (firstCell >= kDisplayDigits) ? firstCell - kDisplayDigits + 1 : 0);
+  gLastVisibleWindow = clampScrollIndex(lastCell);
+
+  const size_t gapCells = gStrip.gapEnd - gStrip.gapStart;
+  gBlankWindowStart = kPaddingSpaces + gStrip.gapStart;
+  gBlankWindowEnd = (gapCells >= kDisplayDigits)
+                        ? gBlankWindowStart + gapCells - kDisplayDigits + 1
+                        : gBlankWindowStart;
+
+  const size_t leftAligned = clampScrollIndex(firstCell);
+  const size_t rightAligned = clampScrollIndex(
+      (lastCell + 1 >= kDisplayDigits) ? lastCell + 1 - kDisplayDigits : 0);
+  gAlignedLowIndex = (leftAligned < rightAligned) ? leftAligned : rightAligned;
+  gAlignedHighIndex =
+      (leftAligned < rightAligned) ? rightAligned : leftAligned;
+  gLeftAlignedIndex = leftAligned;
+}
 
-  gScrollLimit =
-      (gPaddedLength >= kDisplayDigits) ? (gPaddedLength - kDisplayDigits) + 1
-                                        : 1;
-  if (gScrollLimit == 0) {
-    gScrollLimit = 1;
-  }
+// Sizes the scroll range around gStrip.
+void layoutStrip() {
+  gPaddedLength = gStrip.length + 2 * kPaddingSpaces;
+  gScrollLimit = gPaddedLength - kDisplayDigits + 1;
   if (gScrollIndex >= gScrollLimit) {
     gScrollIndex = 0;
   }
-}
 
-bool windowHasVisibleChars(size_t index) {
-  if (index >= gPaddedLength) {
-    return false;
-  }
+  updateVisibleEdges();
+}
 
-  for (size_t digit = 0; digit < kDisplayDigits; ++digit) {
-    const size_t charIndex = index + digit;
-    if (charIndex >= gPaddedLength) {
-      break;
-    }
-    if (gPaddedMessage[charIndex] != ' ') {
-      return true;
+// Encodes gMessage into gStrip once so scrolling only copies cells. The
+// padding around the text is implied by gStrip's bounds, not stored.
+void encodeMessage() {
+  const size_t length =
+      (gMessageLength < kMaxMessageLength) ? gMessageLength : kMaxMessageLength;
+  uint8_t firstVisible = static_cast<uint8_t>(length);
+  uint8_t lastVisible = 0;
+  uint8_t gapStart = 0;
+  uint8_t gapEnd = 0;
+  for (size_t i = 0; i < length; ++i) {
+    gMessageSegments[i] = encodeChar(gMessage[i]);
+    if (gMessage[i] != ' ') {
+      if (firstVisible == length) {
+        firstVisible = static_cast<uint8_t>(i);
+      } else if (i - lastVisible > gapEnd - gapStart + 1u) {
+        gapStart = lastVisible + 1;
+        gapEnd = static_cast<uint8_t>(i);
+      }
+      lastVisible = static_cast<uint8_t>(i);
     }
   }
 
-  return false;
+  gStrip = {gMessageSegments, static_cast<uint8_t>(length), firstVisible,
+            lastVisible, gapStart, gapEnd, false};
+  layoutStrip();
+}
+
+bool windowHasVisibleChars(size_t index) {
+  return gHasVisibleChars && index >= gFirstVisibleWindow &&
+         index <= gLastVisibleWindow &&
+         (index < gBlankWindowStart || index >= gBlankWindowEnd);
+}
+
+bool atForwardEdge(size_t edgeIndex) {
+  return (gScrollDirection >= 0) ? gScrollIndex >= edgeIndex
+                                 : gScrollIndex <= edgeIndex;
 }
 
 bool handlePingPongBounce() {
@@ -235,25 +502,20 @@ bool handlePingPongBounce() {
     return false;
   }
 
-  bool nextWindowHasChars = false;
-  if (gScrollDirection >= 0) {
-    if ((gScrollIndex + 1) < gScrollLimit) {
-      nextWindowHasChars = windowHasVisibleChars(gScrollIndex + 1);
-    }
-  } else {
-    if (gScrollIndex > 0) {
-      nextWindowHasChars = windowHasVisibleChars(gScrollIndex - 1);
-    }
-  }
-
-  if (nextWindowHasChars) {
+  // Bounce on the last step before the text leaves the display.
+  const bool hasNextWindow = (gScrollDirection >= 0)
+                                 ? gScrollIndex + 1 < gScrollLimit
+                                 : gScrollIndex > 0;
+  const size_t nextIndex =
+      (gScrollDirection >= 0) ? gScrollIndex + 1 : gScrollIndex - 1;
+  if (hasNextWindow && windowHasVisibleChars(nextIndex)) {
     return false;
   }
 
   gScrollDirection = (gScrollDirection >= 0) ? -1 : 1;
   gPingPongState = PingPongState::None;
 
-  setMessage(kPongResponse, kPongResponseLength);
+  showStrip(stripFromFlash(kPongBanner));
 
   if (gScrollLimit > 0) {
     if (gScrollDirection >= 0) {
@@ -268,8 +530,62 @@ bool handlePingPongBounce() {
   return true;
 }
 
+void reverseScrollDirection() {
+  gScrollDirection = (gScrollDirection >= 0) ? -1 : 1;
+}
+
+// Returns false when the current mode keeps the window where it is.
+bool applyMarqueeMode() {
+  if (!gHasVisibleChars) {
+    return true;
+  }
+
+  const size_t farEdge =
+      (gScrollDirection >= 0) ? gAlignedHighIndex : gAlignedLowIndex;
+
+  switch (gMarqueeMode) {
+  case MarqueeMode::Wrap:
+    return true;
+  case MarqueeMode::Bounce:
+    if (atForwardEdge(farEdge)) {
+      if (gAlignedLowIndex == gAlignedHighIndex) {
+        return false; // Text exactly fills the display; nowhere to go
+      }
+      reverseScrollDirection();
+    }
+    return true;
+  case MarqueeMode::BounceOnce:
+    if (!gMarqueeBounced && atForwardEdge(farEdge)) {
+      reverseScrollDirection();
+      gMarqueeBounced = true;
+    } else if (gMarqueeBounced &&
+               atForwardEdge((gScrollDirection >= 0) ? gScrollLimit - 1 : 0)) {
+      // Back where the pass started; scroll in again.
+      reverseScrollDirection();
+      gMarqueeBounced = false;
+    }
+    return true;
+  case MarqueeMode::ScrollInHold:
+    return !atForwardEdge(farEdge);
+  case MarqueeMode::BlinkHold:
+    if (!atForwardEdge(farEdge)) {
+      return true;
+    }
+    gBlinkVisible = !gBlinkVisible;
+    if (gBlinkVisible) {
+      updateScrollBuffer();
+    } else {
+      memset(gDisplayBuffer, 0, sizeof(gDisplayBuffer));
+    }
+    return false;
+  }
+
+  return true;
+}
+
 void advanceScroll() {
-  if (gScrollLimit <= 1) {
+  if (gFrameStreamActive || gTransitionEffect != TransitionEffect::Cut ||
+      gScrollLimit <= 1) {
     return;
   }
 
@@ -277,6 +593,10 @@ void advanceScroll() {
     return;
   }
 
+  if (!applyMarqueeMode()) {
+    return;
+  }
+
   if (gScrollDirection >= 0) {
     gScrollIndex = (gScrollIndex + 1) % gScrollLimit;
   } else {
@@ -289,6 +609,19 @@ void advanceScroll() {
   updateScrollBuffer();
 }
 
+// Starts scrolling gStrip from the entry edge for the current direction.
+void restartScroll() {
+  gScrollIndex = 0;
+  gTransitionEffect = TransitionEffect::Cut;
+  gMarqueeBounced = false;
+  gBlinkVisible = true;
+  if (gScrollDirection < 0 && gScrollLimit > 0) {
+    gScrollIndex = gScrollLimit - 1;
+  }
+  updateScrollBuffer();
+  gLastScrollMillis = millis();
+}
+
 void setMessage(const char *message, size_t length) {
   if (message == nullptr) {
     length = 0;
@@ -305,12 +638,44 @@ void setMessage(const char *message, size_t length) {
   gMessage[gMessageLength] = '\0';
 
   gScrollIndex = 0;
-  buildPaddedMessage();
-  if (gScrollDirection < 0 && gScrollLimit > 0) {
-    gScrollIndex = gScrollLimit - 1;
+  encodeMessage();
+  restartScroll();
+}
+
+// Plays a pre-encoded strip, e.g. one baked into flash, without copying it.
+void showStrip(const SegmentStripView &strip) {
+  gMessageLength = 0;
+  gMessage[0] = '\0';
+
+  gStrip = strip;
+  gScrollIndex = 0;
+  layoutStrip();
+  restartScroll();
+}
+
+// Non-blocking: the effect runs from refreshDisplay() while loop() keeps
+// servicing serial input. The new text starts left-aligned instead of
+// scrolling in from blank.
+void transitionToMessage(const char *message, size_t length,
+                         TransitionEffect effect) {
+  if (effect == TransitionEffect::Cut) {
+    setMessage(message, length);
+    return;
   }
-  updateScrollBuffer();
-  gLastScrollMillis = millis();
+
+  memcpy(gTransitionFrom, gDisplayBuffer, sizeof(gTransitionFrom));
+  setMessage(message, length);
+  if (gHasVisibleChars) {
+    gScrollIndex = gLeftAlignedIndex;
+    updateScrollBuffer();
+  }
+  memcpy(gTransitionTo, gDisplayBuffer, sizeof(gTransitionTo));
+  memcpy(gDisplayBuffer, gTransitionFrom, sizeof(gDisplayBuffer));
+
+  gTransitionEffect = effect;
+  gTransitionStep = 0;
+  gTransitionFrame = 0;
+  gDissolveCursor = 0;
 }
 
 void updateScrollDirectionFromMessage(const char *message, size_t length) {
@@ -367,7 +732,8 @@ bool isPingCommand(const char *message, size_t length) {
 
   for (size_t i = 0; i < kPingCommandLength; ++i) {
     const char c = message[start + i];
-    if (toupper(static_cast<unsigned char>(c)) != kPingCommand[i]) {
+    if (toupper(static_cast<unsigned char>(c)) !=
+        static_cast<char>(pgm_read_byte(&kPingCommand[i]))) {
       return false;
     }
   }
@@ -375,11 +741,143 @@ bool isPingCommand(const char *message, size_t length) {
   return true;
 }
 
+// Returns the upper-cased tag letter when the line starts with prefix and a
+// letter, or '\0' otherwise.
+char leadingTag(const char *message, size_t length, char prefix) {
+  if (length < 2 || message[0] != prefix) {
+    return '\0';
+  }
+  return static_cast<char>(toupper(static_cast<unsigned char>(message[1])));
+}
+
+// A tag is two characters plus an optional separating space.
+size_t tagLength(const char *message, size_t length) {
+  return (length > 2 && message[2] == ' ') ? 3 : 2;
+}
+
+size_t parseMarqueeMode(const char *message, size_t length,
+                        MarqueeMode &mode) {
+  const char tag = leadingTag(message, length, kMarqueePrefix);
+  for (const auto &entry : kMarqueeTags) {
+    if (tag != '\0' && static_cast<char>(pgm_read_byte(&entry.tag)) == tag) {
+      mode = static_cast<MarqueeMode>(pgm_read_byte(&entry.mode));
+      return tagLength(message, length);
+    }
+  }
+  return 0;
+}
+
+size_t parseTransitionEffect(const char *message, size_t length,
+                             TransitionEffect &effect) {
+  const char tag = leadingTag(message, length, kTransitionPrefix);
+  for (const auto &entry : kTransitionTags) {
+    if (tag != '\0' && static_cast<char>(pgm_read_byte(&entry.tag)) == tag) {
+      effect = static_cast<TransitionEffect>(pgm_read_byte(&entry.effect));
+      return tagLength(message, length);
+    }
+  }
+  return 0;
+}
+
+// Returns the number of characters taken by leading "~<tag>"/"^<tag>"
+// prefixes, in any order, or 0 when the line carries no recognised tag.
+size_t parseMessageTags(const char *message, size_t length, MarqueeMode &mode,
+                        TransitionEffect &effect) {
+  size_t consumed = 0;
+  for (;;) {
+    size_t parsed =
+        parseMarqueeMode(&message[consumed], length - consumed, mode);
+    if (parsed == 0) {
+      parsed = parseTransitionEffect(&message[consumed], length - consumed,
+                                     effect);
+    }
+    if (parsed == 0) {
+      return consumed;
+    }
+    consumed += parsed;
+  }
+}
+
+#ifdef __AVR__
+// Runs before the C runtime sets up the stack: fills everything between the
+// static data and the top of RAM with kStackPaint so stackHeadroomBytes()
+// can find the deepest point the stack (or heap) has ever reached.
+// Naked functions may only hold basic asm, so the fill value is a literal.
+static_assert(kStackPaint == 0xC5, "paintStack() fills with 0xC5");
+void paintStack() __attribute__((naked, used, section(".init1")));
+void paintStack() {
+  asm volatile("  ldi r30, lo8(__heap_start)\n"
+               "  ldi r31, hi8(__heap_start)\n"
+               "  ldi r24, 0xC5\n"
+               "  ldi r25, hi8(__stack)\n"
+               "  rjmp 2f\n"
+               "1:\n"
+               "  st Z+, r24\n"
+               "2:\n"
+               "  cpi r30, lo8(__stack)\n"
+               "  cpc r31, r25\n"
+               "  brlo 1b\n"
+               "  breq 1b\n");
+}
+#endif
+
+// Bytes between the heap end and the current stack pointer.
+size_t freeRamBytes() {
+#ifdef __AVR__
+  uint8_t top;
+  const uint8_t *heapEnd = (__brkval != nullptr)
+                               ? static_cast<const uint8_t *>(__brkval)
+                               : &__heap_start;
+  return static_cast<size_t>(&top - heapEnd);
+#else
+  return 0;
+#endif
+}
+
+// Bytes above the heap that the stack has never touched since reset.
+size_t stackHeadroomBytes() {
+#ifdef __AVR__
+  const uint8_t *p = (__brkval != nullptr)
+                         ? static_cast<const uint8_t *>(__brkval)
+                         : &__heap_start;
+  size_t untouched = 0;
+  while (p <= &__stack && *p == kStackPaint) {
+    ++p;
+    ++untouched;
+  }
+  return untouched;
+#else
+  return 0;
+#endif
+}
+
+void reportMemory() {
+  Serial.print(F("RAM free: "));
+  Serial.print(freeRamBytes());
+  Serial.print(F(" bytes, stack headroom: "));
+  Serial.print(stackHeadroomBytes());
+  Serial.println(F(" bytes"));
+}
+
 void commitSerialMessage() {
   gSerialInputBuffer[gSerialInputLength] = '\0';
-  const bool isPing = isPingCommand(gSerialInputBuffer, gSerialInputLength);
-  updateScrollDirectionFromMessage(gSerialInputBuffer, gSerialInputLength);
-  setMessage(gSerialInputBuffer, gSerialInputLength);
+  if (gSerialInputLength == 1 && gSerialInputBuffer[0] == kStatusQuery) {
+    gSerialInputLength = 0;
+    reportMemory();
+    return;
+  }
+
+  MarqueeMode mode = MarqueeMode::Wrap;
+  TransitionEffect effect = TransitionEffect::Cut;
+  const size_t tagsLength =
+      parseMessageTags(gSerialInputBuffer, gSerialInputLength, mode, effect);
+  const char *text = &gSerialInputBuffer[tagsLength];
+  const size_t textLength = gSerialInputLength - tagsLength;
+
+  const bool isPing = isPingCommand(text, textLength);
+  updateScrollDirectionFromMessage(text, textLength);
+  gMarqueeMode = mode;
+  transitionToMessage(text, textLength, effect);
   gPingPongState =
       isPing ? PingPongState::AwaitingBounce : PingPongState::None;
   gSerialInputLength = 0;
@@ -388,10 +886,194 @@ void commitSerialMessage() {
   Serial.println(gMessage);
 }
 
+uint16_t crc16Update(uint16_t crc, uint8_t data) {
+  crc ^= static_cast<uint16_t>(data) << 8;
+  for (uint8_t bit = 0; bit < 8; ++bit) {
+    crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021)
+                         : static_cast<uint16_t>(crc << 1);
+  }
+  return crc;
+}
+
+uint16_t crc16(const uint8_t *data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; ++i) {
+    crc = crc16Update(crc, data[i]);
+  }
+  return crc;
+}
+
+// Output never outgrows the input, so decoding in place is safe. Returns 0
+// for malformed input.
+size_t cobsDecode(const uint8_t *input, size_t length, uint8_t *output) {
+  size_t readIndex = 0;
+  size_t writeIndex = 0;
+  while (readIndex < length) {
+    const uint8_t code = input[readIndex++];
+    if (code == 0 || (readIndex + code - 1) > length) {
+      return 0;
+    }
+    for (uint8_t i = 1; i < code; ++i) {
+      output[writeIndex++] = input[readIndex++];
+    }
+    if (code != 0xFF && readIndex < length) {
+      output[writeIndex++] = 0;
+    }
+  }
+  return writeIndex;
+}
+
+// Output must hold length + length / 254 + 1 bytes. Returns encoded length.
+size_t cobsEncode(const uint8_t *input, size_t length, uint8_t *output) {
+  size_t codeIndex = 0;
+  size_t writeIndex = 1;
+  uint8_t code = 1;
+  for (size_t i = 0; i < length; ++i) {
+    if (input[i] != 0) {
+      output[writeIndex++] = input[i];
+      ++code;
+    }
+    if (input[i] == 0 || code == 0xFF) {
+      output[codeIndex] = code;
+      codeIndex = writeIndex++;
+      code = 1;
+    }
+  }
+  output[codeIndex] = code;
+  return writeIndex;
+}
+
+void sendFrameResponse(FrameStatus status, uint8_t sequence) {
+  const FrameOpcode opcode =
+      (status == FrameStatus::Ok) ? FrameOpcode::Ack : FrameOpcode::Nak;
+  uint8_t packet[kFrameHeaderLength + 1 + kFrameCrcLength] = {
+      static_cast<uint8_t>(opcode), sequence, static_cast<uint8_t>(status)};
+  const uint16_t crc = crc16(packet, kFrameHeaderLength + 1);
+  packet[kFrameHeaderLength + 1] = static_cast<uint8_t>(crc & 0xFF);
+  packet[kFrameHeaderLength + 2] = static_cast<uint8_t>(crc >> 8);
+
+  uint8_t encoded[sizeof(packet) + 2];
+  const size_t encodedLength = cobsEncode(packet, sizeof(packet), encoded);
+  encoded[encodedLength] = kFrameDelimiter;
+  Serial.write(encoded, encodedLength + 1);
+}
+
+void releaseFrameStream() {
+  gFrameStreamActive = false;
+  gHaveFrameSequence = false;
+  updateScrollBuffer();
+  gLastScrollMillis = millis();
+}
+
+FrameStatus applyFramePacket(FrameOpcode opcode, uint8_t sequence,
+                             const uint8_t *payload, size_t payloadLength) {
+  switch (opcode) {
+  case FrameOpcode::SegmentFrame:
+    if (payloadLength != kDisplayDigits) {
+      return FrameStatus::BadLength;
+    }
+    // Hosts keep several packets in flight and resend NAKed ones, so a
+    // frame can arrive after newer ones; acknowledge it without drawing.
+    if (gHaveFrameSequence &&
+        static_cast<int8_t>(sequence - gLastFrameSequence) <= 0) {
+      return FrameStatus::Ok;
+    }
+    memcpy(gDisplayBuffer, payload, kDisplayDigits);
+    gTransitionEffect = TransitionEffect::Cut;
+    gFrameStreamActive = true;
+    gHaveFrameSequence = true;
+    gLastFrameSequence = sequence;
+    return FrameStatus::Ok;
+  case FrameOpcode::Brightness:
+    if (payloadLength != 1) {
+      return FrameStatus::BadLength;
+    }
+    setBrightness(payload[0]);
+    return FrameStatus::Ok;
+  case FrameOpcode::ResumeScroll:
+  case FrameOpcode::ExitBinary:
+    if (payloadLength != 0) {
+      return FrameStatus::BadLength;
+    }
+    releaseFrameStream();
+    if (opcode == FrameOpcode::ExitBinary) {
+      gSerialMode = SerialMode::Text;
+    }
+    return FrameStatus::Ok;
+  default:
+    return FrameStatus::BadOpcode;
+  }
+}
+
+void handleFramePacket(const uint8_t *packet, size_t length) {
+  if (length < kFrameHeaderLength + kFrameCrcLength) {
+    sendFrameResponse(FrameStatus::BadEncoding, 0);
+    return;
+  }
+
+  const size_t bodyLength = length - kFrameCrcLength;
+  const uint8_t sequence = packet[1];
+  const uint16_t crcHigh = packet[bodyLength + 1];
+  const uint16_t expectedCrc =
+      static_cast<uint16_t>(packet[bodyLength] | (crcHigh << 8));
+  if (crc16(packet, bodyLength) != expectedCrc) {
+    sendFrameResponse(FrameStatus::BadCrc, sequence);
+    return;
+  }
+
+  const FrameStatus status = applyFramePacket(
+      static_cast<FrameOpcode>(packet[0]), sequence,
+      &packet[kFrameHeaderLength], bodyLength - kFrameHeaderLength);
+  sendFrameResponse(status, sequence);
+}
+
+void processFramedByte(uint8_t incoming) {
+  if (incoming != kFrameDelimiter) {
+    if (gEncodedFrameLength < kMaxEncodedFrameLength) {
+      gEncodedFrame[gEncodedFrameLength++] = incoming;
+    } else {
+      gEncodedFrameOverflow = true;
+    }
+    return;
+  }
+
+  // Back-to-back delimiters are empty frames; hosts send them to resync when
+  // they start a stream, so sequence numbering starts over.
+  if (gEncodedFrameOverflow) {
+    sendFrameResponse(FrameStatus::Overflow, 0);
+  } else if (gEncodedFrameLength == 0) {
+    gHaveFrameSequence = false;
+  } else {
+    const size_t decodedLength =
+        cobsDecode(gEncodedFrame, gEncodedFrameLength, gEncodedFrame);
+    if (decodedLength == 0) {
+      sendFrameResponse(FrameStatus::BadEncoding, 0);
+    } else {
+      handleFramePacket(gEncodedFrame, decodedLength);
+    }
+  }
+
+  gEncodedFrameLength = 0;
+  gEncodedFrameOverflow = false;
+}
+
 void processSerialInput() {
   while (Serial.available() > 0) {
     const char incoming = Serial.read();
 
+    if (gSerialMode == SerialMode::Binary) {
+      processFramedByte(static_cast<uint8_t>(incoming));
+      continue;
+    }
+
+    if (static_cast<uint8_t>(incoming) == kFrameDelimiter) {
+      gSerialMode = SerialMode::Binary;
+      gSerialInputLength = 0;
+      gEncodedFrameLength = 0;
+      gEncodedFrameOverflow = false;
+      continue;
+    }
+
     if (incoming == '\r') {
       commitSerialMessage();
       gIgnoreNextLinefeed = true;
@@ -425,8 +1107,14 @@ void processSerialInput() {
 }
 
 void setup() {
+  BENCH_LOOP_SETUP();
   Serial.begin(115200);
   Serial.println(F("Send text followed by ENTER to update the scroll."));
+  Serial.println(F("Prefix ~W wrap, ~B bounce, ~O bounce once, ~H hold, "
+                   "~K blink hold."));
+  Serial.println(F("Prefix ^W wipe, ^D dissolve, ^U push up, ^F dash flip."));
+  Serial.println(F("Send 0x00 to switch to COBS-framed segment streaming."));
+  Serial.println(F("Send ? to report free RAM and stack headroom."));
 
   for (uint8_t pin : kSegmentPins) {
     pinMode(pin, OUTPUT);
@@ -438,13 +1126,15 @@ void setup() {
   }
   disableAllDigits();
 
-  setMessage(kDefaultMessage, strlen(kDefaultMessage));
+  showStrip(stripFromFlash(kDefaultBanner));
 
   gCurrentDigit = kDisplayDigits - 1;
   gLastRefreshMicros = micros();
+  reportMemory();
 }
 
 void loop() {
+  BENCH_LOOP_MARK();
   processSerialInput();
 
   const unsigned long nowMicros = micros();
@@ -452,6 +1142,7 @@ void loop() {
     gLastRefreshMicros = nowMicros;
     refreshDisplay();
   }
+  dimDisplay(nowMicros);
 
   const unsigned long nowMillis = millis();
   if (nowMillis - gLastScrollMillis >= kScrollIntervalMillis) {
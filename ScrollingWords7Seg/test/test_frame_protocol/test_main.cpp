@@ -0,0 +1,261 @@
+// Host tests for the COBS/CRC binary frame protocol. The firmware is compiled
+// into its own namespace, as in bench/host, and driven through
+// processFramedByte(); responses are read back from Serial's last write().
+
+#include <Arduino.h>
+#include <SegmentStrip.h>
+#include <unity.h>
+
+HostSerial Serial;
+
+namespace scrolling {
+#include "../../src/main.cpp"
+} // namespace scrolling
+
+using namespace scrolling;
+
+namespace {
+
+struct Response {
+  uint8_t opcode;
+  uint8_t sequence;
+  uint8_t status;
+};
+
+constexpr uint8_t kBlankFrame[kDisplayDigits] = {};
+constexpr uint8_t kFrameA[kDisplayDigits] = {0x3F, 0x06, 0x5B, 0x4F,
+                                             0x66, 0x6D, 0x7D, 0x07};
+constexpr uint8_t kFrameB[kDisplayDigits] = {0x01, 0x02, 0x04, 0x08,
+                                             0x10, 0x20, 0x40, 0x00};
+constexpr uint8_t kFrameC[kDisplayDigits] = {0x7F, 0x00, 0x7F, 0x00,
+                                             0x7F, 0x00, 0x7F, 0x00};
+
+size_t buildPacket(FrameOpcode opcode, uint8_t sequence,
+                   const uint8_t *payload, size_t payloadLength,
+                   uint8_t *packet) {
+  packet[0] = static_cast<uint8_t>(opcode);
+  packet[1] = sequence;
+  if (payloadLength > 0) {
+    memcpy(&packet[kFrameHeaderLength], payload, payloadLength);
+  }
+  const size_t bodyLength = kFrameHeaderLength + payloadLength;
+  const uint16_t crc = crc16(packet, bodyLength);
+  packet[bodyLength] = static_cast<uint8_t>(crc & 0xFF);
+  packet[bodyLength + 1] = static_cast<uint8_t>(crc >> 8);
+  return bodyLength + kFrameCrcLength;
+}
+
+void receiveEncoded(const uint8_t *packet, size_t length) {
+  uint8_t encoded[64];
+  const size_t encodedLength = cobsEncode(packet, length, encoded);
+  for (size_t i = 0; i < encodedLength; ++i) {
+    processFramedByte(encoded[i]);
+  }
+  processFramedByte(kFrameDelimiter);
+}
+
+void receivePacket(FrameOpcode opcode, uint8_t sequence,
+                   const uint8_t *payload, size_t payloadLength) {
+  uint8_t packet[kMaxFrameLength + 8];
+  receiveEncoded(packet,
+                 buildPacket(opcode, sequence, payload, payloadLength, packet));
+}
+
+Response lastResponse() {
+  TEST_ASSERT_TRUE(Serial.lastWriteLength > 1);
+  TEST_ASSERT_EQUAL_HEX8(kFrameDelimiter,
+                         Serial.lastWrite[Serial.lastWriteLength - 1]);
+
+  uint8_t packet[sizeof(Serial.lastWrite)];
+  const size_t length =
+      cobsDecode(Serial.lastWrite, Serial.lastWriteLength - 1, packet);
+  TEST_ASSERT_EQUAL(kFrameHeaderLength + 1 + kFrameCrcLength, length);
+  TEST_ASSERT_EQUAL_HEX16(crc16(packet, kFrameHeaderLength + 1),
+                          packet[3] | (packet[4] << 8));
+  Serial.lastWriteLength = 0;
+  return {packet[0], packet[1], packet[2]};
+}
+
+void assertResponse(FrameOpcode opcode, uint8_t sequence,
+                    FrameStatus status) {
+  const Response response = lastResponse();
+  TEST_ASSERT_EQUAL_HEX8(static_cast<uint8_t>(opcode), response.opcode);
+  TEST_ASSERT_EQUAL_UINT8(sequence, response.sequence);
+  TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(status), response.status);
+}
+
+void assertDisplay(const uint8_t *expected) {
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, gDisplayBuffer, kDisplayDigits);
+}
+
+void assertCobsRoundTrip(size_t length) {
+  uint8_t input[600];
+  uint8_t encoded[sizeof(input) + sizeof(input) / 254 + 1];
+  uint8_t decoded[sizeof(input)];
+  for (size_t i = 0; i < length; ++i) {
+    input[i] = static_cast<uint8_t>((i % 97 == 0) ? 0 : i);
+  }
+
+  const size_t encodedLength = cobsEncode(input, length, encoded);
+  TEST_ASSERT_TRUE(encodedLength <= length + length / 254 + 1);
+  for (size_t i = 0; i < encodedLength; ++i) {
+    TEST_ASSERT_NOT_EQUAL(0, encoded[i]);
+  }
+  TEST_ASSERT_EQUAL(length, cobsDecode(encoded, encodedLength, decoded));
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(input, decoded, length);
+}
+
+} // namespace
+
+void setUp() {
+  releaseFrameStream();
+  memset(gDisplayBuffer, 0, sizeof(gDisplayBuffer));
+  gSerialMode = SerialMode::Binary;
+  gEncodedFrameLength = 0;
+  gEncodedFrameOverflow = false;
+  Serial.lastWriteLength = 0;
+}
+
+void tearDown() {}
+
+void test_crc16_check_value() {
+  const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  TEST_ASSERT_EQUAL_HEX16(0x29B1, crc16(check, sizeof(check)));
+}
+
+void test_cobs_round_trip_across_block_boundary() {
+  const size_t lengths[] = {1, 96, 253, 254, 255, 508, 509, 600};
+  for (size_t length : lengths) {
+    assertCobsRoundTrip(length);
+  }
+}
+
+void test_cobs_full_block_has_no_trailing_zero() {
+  uint8_t input[254];
+  uint8_t encoded[sizeof(input) + 2];
+  uint8_t decoded[sizeof(input)];
+  memset(input, 0xA5, sizeof(input));
+
+  const size_t encodedLength = cobsEncode(input, sizeof(input), encoded);
+  TEST_ASSERT_EQUAL(sizeof(input) + 2, encodedLength);
+  TEST_ASSERT_EQUAL_HEX8(0xFF, encoded[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x01, encoded[encodedLength - 1]);
+  TEST_ASSERT_EQUAL(sizeof(input),
+                    cobsDecode(encoded, encodedLength, decoded));
+}
+
+void test_cobs_rejects_truncated_block() {
+  const uint8_t encoded[] = {0x05, 0x11, 0x22};
+  uint8_t decoded[8];
+  TEST_ASSERT_EQUAL(0, cobsDecode(encoded, sizeof(encoded), decoded));
+}
+
+void test_segment_frame_is_drawn_and_acked() {
+  receivePacket(FrameOpcode::SegmentFrame, 7, kFrameA, kDisplayDigits);
+  assertResponse(FrameOpcode::Ack, 7, FrameStatus::Ok);
+  assertDisplay(kFrameA);
+  TEST_ASSERT_TRUE(gFrameStreamActive);
+}
+
+void test_corrupted_crc_is_naked() {
+  uint8_t packet[kMaxFrameLength];
+  const size_t length = buildPacket(FrameOpcode::SegmentFrame, 9, kFrameA,
+                                    kDisplayDigits, packet);
+  packet[length - 1] ^= 0x40;
+  receiveEncoded(packet, length);
+
+  assertResponse(FrameOpcode::Nak, 9, FrameStatus::BadCrc);
+  assertDisplay(kBlankFrame);
+  TEST_ASSERT_FALSE(gFrameStreamActive);
+}
+
+void test_payload_length_checks() {
+  receivePacket(FrameOpcode::SegmentFrame, 1, kFrameA, kDisplayDigits - 1);
+  assertResponse(FrameOpcode::Nak, 1, FrameStatus::BadLength);
+  TEST_ASSERT_FALSE(gFrameStreamActive);
+
+  receivePacket(FrameOpcode::Brightness, 2, nullptr, 0);
+  assertResponse(FrameOpcode::Nak, 2, FrameStatus::BadLength);
+
+  receivePacket(FrameOpcode::ExitBinary, 3, kFrameA, 1);
+  assertResponse(FrameOpcode::Nak, 3, FrameStatus::BadLength);
+  TEST_ASSERT_TRUE(gSerialMode == SerialMode::Binary);
+
+  receivePacket(static_cast<FrameOpcode>(0x7E), 4, nullptr, 0);
+  assertResponse(FrameOpcode::Nak, 4, FrameStatus::BadOpcode);
+}
+
+void test_framing_errors_are_naked_with_sequence_zero() {
+  const uint8_t shortPacket[] = {static_cast<uint8_t>(FrameOpcode::Ack), 5,
+                                 0x12};
+  receiveEncoded(shortPacket, sizeof(shortPacket));
+  assertResponse(FrameOpcode::Nak, 0, FrameStatus::BadEncoding);
+
+  for (size_t i = 0; i <= kMaxEncodedFrameLength; ++i) {
+    processFramedByte(0x01);
+  }
+  processFramedByte(kFrameDelimiter);
+  assertResponse(FrameOpcode::Nak, 0, FrameStatus::Overflow);
+
+  const uint8_t truncated[] = {0x09, 0x01, 0x02};
+  for (uint8_t byte : truncated) {
+    processFramedByte(byte);
+  }
+  processFramedByte(kFrameDelimiter);
+  assertResponse(FrameOpcode::Nak, 0, FrameStatus::BadEncoding);
+}
+
+void test_duplicate_and_stale_frames_are_acked_but_not_drawn() {
+  receivePacket(FrameOpcode::SegmentFrame, 5, kFrameA, kDisplayDigits);
+  assertResponse(FrameOpcode::Ack, 5, FrameStatus::Ok);
+
+  receivePacket(FrameOpcode::SegmentFrame, 5, kFrameB, kDisplayDigits);
+  assertResponse(FrameOpcode::Ack, 5, FrameStatus::Ok);
+  assertDisplay(kFrameA);
+
+  receivePacket(FrameOpcode::SegmentFrame, 3, kFrameB, kDisplayDigits);
+  assertResponse(FrameOpcode::Ack, 3, FrameStatus::Ok);
+  assertDisplay(kFrameA);
+
+  receivePacket(FrameOpcode::SegmentFrame, 6, kFrameC, kDisplayDigits);
+  assertResponse(FrameOpcode::Ack, 6, FrameStatus::Ok);
+  assertDisplay(kFrameC);
+}
+
+void test_sequence_numbers_wrap() {
+  receivePacket(FrameOpcode::SegmentFrame, 254, kFrameA, kDisplayDigits);
+  receivePacket(FrameOpcode::SegmentFrame, 255, kFrameB, kDisplayDigits);
+  receivePacket(FrameOpcode::SegmentFrame, 0, kFrameC, kDisplayDigits);
+  assertResponse(FrameOpcode::Ack, 0, FrameStatus::Ok);
+  assertDisplay(kFrameC);
+
+  receivePacket(FrameOpcode::SegmentFrame, 255, kFrameA, kDisplayDigits);
+  assertDisplay(kFrameC);
+}
+
+void test_resync_restarts_sequence_numbering() {
+  receivePacket(FrameOpcode::SegmentFrame, 40, kFrameA, kDisplayDigits);
+  assertResponse(FrameOpcode::Ack, 40, FrameStatus::Ok);
+  processFramedByte(kFrameDelimiter);
+  TEST_ASSERT_EQUAL(0, Serial.lastWriteLength); // Empty frames are not answered
+
+  receivePacket(FrameOpcode::SegmentFrame, 0, kFrameB, kDisplayDigits);
+  assertResponse(FrameOpcode::Ack, 0, FrameStatus::Ok);
+  assertDisplay(kFrameB);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_crc16_check_value);
+  RUN_TEST(test_cobs_round_trip_across_block_boundary);
+  RUN_TEST(test_cobs_full_block_has_no_trailing_zero);
+  RUN_TEST(test_cobs_rejects_truncated_block);
+  RUN_TEST(test_segment_frame_is_drawn_and_acked);
+  RUN_TEST(test_corrupted_crc_is_naked);
+  RUN_TEST(test_payload_length_checks);
+  RUN_TEST(test_framing_errors_are_naked_with_sequence_zero);
+  RUN_TEST(test_duplicate_and_stale_frames_are_acked_but_not_drawn);
+  RUN_TEST(test_sequence_numbers_wrap);
+  RUN_TEST(test_resync_restarts_sequence_numbering);
+  return UNITY_END();
+}
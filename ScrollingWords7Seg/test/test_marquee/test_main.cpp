@@ -0,0 +1,190 @@
+// Host tests for the marquee modes and the ping bounce. Lines are fed through
+// commitSerialMessage() and the scroll is stepped with advanceScroll(), as
+// loop() would every kScrollIntervalMillis.
+
+#include <Arduino.h>
+#include <SegmentStrip.h>
+#include <unity.h>
+
+HostSerial Serial;
+
+namespace scrolling {
+#include "../../src/main.cpp"
+} // namespace scrolling
+
+using namespace scrolling;
+
+namespace {
+
+constexpr int kForward = 1;   // right-to-left, scroll index rising
+constexpr int kBackward = -1; // left-to-right, scroll index falling
+constexpr size_t kMaxSteps = 200;
+
+void receiveLine(const char *line) {
+  gSerialInputLength = strlen(line);
+  memcpy(gSerialInputBuffer, line, gSerialInputLength);
+  commitSerialMessage();
+}
+
+void startMarquee(int direction, const char *line) {
+  gScrollDirection = direction;
+  receiveLine(line);
+}
+
+// Steps until the scroll direction flips and returns the index it flipped at.
+size_t stepToReversal() {
+  const int direction = gScrollDirection;
+  for (size_t step = 0; step < kMaxSteps; ++step) {
+    const size_t index = gScrollIndex;
+    advanceScroll();
+    if (gScrollDirection != direction) {
+      return index;
+    }
+  }
+  TEST_FAIL_MESSAGE("scroll direction never reversed");
+  return 0;
+}
+
+// Steps until the ping bounce has happened and returns the index it left at.
+size_t stepToPingBounce() {
+  for (size_t step = 0; step < kMaxSteps; ++step) {
+    const size_t index = gScrollIndex;
+    advanceScroll();
+    if (gPingPongState == PingPongState::None) {
+      return index;
+    }
+  }
+  TEST_FAIL_MESSAGE("ping never bounced");
+  return 0;
+}
+
+void stepScroll(size_t steps) {
+  for (size_t step = 0; step < steps; ++step) {
+    advanceScroll();
+  }
+}
+
+void assertBounces(int direction, const char *line, size_t firstEdge,
+                   size_t secondEdge) {
+  startMarquee(direction, line);
+  TEST_ASSERT_EQUAL(firstEdge, stepToReversal());
+  TEST_ASSERT_EQUAL(secondEdge, stepToReversal());
+  TEST_ASSERT_EQUAL(firstEdge, stepToReversal());
+}
+
+void assertHolds(int direction, const char *line, size_t holdIndex) {
+  startMarquee(direction, line);
+  stepScroll(2 * gScrollLimit);
+  TEST_ASSERT_EQUAL(holdIndex, gScrollIndex);
+  TEST_ASSERT_EQUAL(direction, gScrollDirection);
+  advanceScroll();
+  TEST_ASSERT_EQUAL(holdIndex, gScrollIndex);
+  TEST_ASSERT_EQUAL(direction, gScrollDirection);
+}
+
+// Checks that text starts at firstDigit, which may lie left of the display.
+void assertWindow(const char *text, int firstDigit) {
+  for (size_t digit = 0; digit < kDisplayDigits; ++digit) {
+    const int cell = static_cast<int>(digit) - firstDigit;
+    const uint8_t expected =
+        (cell >= 0 && cell < static_cast<int>(strlen(text)))
+            ? encodeChar(text[cell])
+            : 0;
+    TEST_ASSERT_EQUAL_HEX8(expected, gDisplayBuffer[digit]);
+  }
+}
+
+} // namespace
+
+void setUp() {
+  releaseFrameStream();
+  gSerialMode = SerialMode::Text;
+  gPingPongState = PingPongState::None;
+  gScrollDirection = kForward;
+}
+
+void tearDown() {}
+
+// Short text starts a display width in (index 8) and ends flush right at
+// index 8 - 8 + length; the scroll range starts at 0.
+void test_short_text_bounces_between_display_edges() {
+  assertBounces(kForward, "~B HI", 8, 2);
+  assertBounces(kBackward, "~B HI", 2, 8);
+}
+
+void test_display_wide_text_holds_in_bounce_mode() {
+  assertHolds(kForward, "~B SCROLLER", 8);
+  assertWindow("SCROLLER", 0);
+  assertHolds(kBackward, "~B SCROLLER", 8);
+  assertWindow("SCROLLER", 0);
+}
+
+void test_long_text_bounces_between_text_edges() {
+  assertBounces(kForward, "~B HELLO WORLD", 11, 8);
+  assertBounces(kBackward, "~B HELLO WORLD", 8, 11);
+}
+
+void test_scroll_in_hold_stops_at_far_edge() {
+  assertHolds(kForward, "~H HI", 8);
+  assertWindow("HI", 0);
+  assertHolds(kBackward, "~H HI", 2);
+  assertWindow("HI", 6);
+
+  assertHolds(kForward, "~H SCROLLER", 8);
+  assertHolds(kBackward, "~H SCROLLER", 8);
+  assertWindow("SCROLLER", 0);
+
+  assertHolds(kForward, "~H HELLO WORLD", 11);
+  assertWindow("HELLO WORLD", -3);
+  assertHolds(kBackward, "~H HELLO WORLD", 8);
+  assertWindow("HELLO WORLD", 0);
+}
+
+void test_blink_hold_blanks_every_other_step_once_aligned() {
+  assertHolds(kForward, "~K HELLO WORLD", 11);
+  const bool visible = gBlinkVisible;
+  advanceScroll();
+  TEST_ASSERT_TRUE(gBlinkVisible != visible);
+  if (gBlinkVisible) {
+    assertWindow("HELLO WORLD", -3);
+  } else {
+    assertWindow("", 0);
+  }
+  TEST_ASSERT_EQUAL(11, gScrollIndex);
+}
+
+// Ping bounces on the last step before the text leaves the display; windows
+// inside a display-wide run of spaces count as having left it.
+void test_ping_bounces_when_text_leaves_the_display() {
+  startMarquee(kForward, "PING 9");
+  TEST_ASSERT_EQUAL(13, stepToPingBounce());
+  TEST_ASSERT_EQUAL(kBackward, gScrollDirection);
+
+  startMarquee(kBackward, "PING 0");
+  TEST_ASSERT_EQUAL(1, stepToPingBounce());
+  TEST_ASSERT_EQUAL(kForward, gScrollDirection);
+}
+
+void test_ping_bounces_before_a_display_wide_gap() {
+  startMarquee(kForward, "PING         9");
+  TEST_ASSERT_EQUAL(11, stepToPingBounce());
+
+  startMarquee(kBackward, "PING         0");
+  TEST_ASSERT_EQUAL(14, stepToPingBounce());
+
+  // Seven spaces never blank the whole display.
+  startMarquee(kForward, "PING       9");
+  TEST_ASSERT_EQUAL(19, stepToPingBounce());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_short_text_bounces_between_display_edges);
+  RUN_TEST(test_display_wide_text_holds_in_bounce_mode);
+  RUN_TEST(test_long_text_bounces_between_text_edges);
+  RUN_TEST(test_scroll_in_hold_stops_at_far_edge);
+  RUN_TEST(test_blink_hold_blanks_every_other_step_once_aligned);
+  RUN_TEST(test_ping_bounces_when_text_leaves_the_display);
+  RUN_TEST(test_ping_bounces_before_a_display_wide_gap);
+  return UNITY_END();
+}
@@ -0,0 +1,167 @@
+// Host tests for the transition effects. Lines are fed through
+// commitSerialMessage() and each effect is run one advanceTransition() call
+// per scan frame, as refreshDisplay() does when the digit scan wraps.
+
+#include <Arduino.h>
+#include <SegmentStrip.h>
+#include <unity.h>
+
+HostSerial Serial;
+
+namespace scrolling {
+#include "../../src/main.cpp"
+} // namespace scrolling
+
+using namespace scrolling;
+
+namespace {
+
+constexpr size_t kMaxFrames = 1000;
+
+// An effect renders one step per kTransitionFramesPerStep frames and ends on
+// the first step it has nothing left to render.
+constexpr size_t effectFrames(size_t renderedSteps) {
+  return (renderedSteps + 1) * kTransitionFramesPerStep;
+}
+
+constexpr size_t kWipeFrames = effectFrames(kDisplayDigits);
+constexpr size_t kDissolveFrames = effectFrames(
+    (kDissolveCells + kDissolveCellsPerStep - 1) / kDissolveCellsPerStep);
+constexpr size_t kPushUpFrames = effectFrames(2);
+constexpr size_t kDashFlipFrames = effectFrames(2);
+
+void receiveLine(const char *line) {
+  gSerialInputLength = strlen(line);
+  memcpy(gSerialInputBuffer, line, gSerialInputLength);
+  commitSerialMessage();
+}
+
+bool transitionRunning() {
+  return gTransitionEffect != TransitionEffect::Cut;
+}
+
+void advanceFrames(size_t frames) {
+  for (size_t frame = 0; frame < frames; ++frame) {
+    advanceTransition();
+  }
+}
+
+size_t framesUntilDone() {
+  size_t frames = 0;
+  while (transitionRunning() && frames < kMaxFrames) {
+    advanceTransition();
+    ++frames;
+  }
+  return frames;
+}
+
+// Transitions leave the new text left-aligned.
+void assertShowsLeftAligned(const char *text) {
+  for (size_t digit = 0; digit < kDisplayDigits; ++digit) {
+    const uint8_t expected =
+        (digit < strlen(text)) ? encodeChar(text[digit]) : 0;
+    TEST_ASSERT_EQUAL_HEX8(expected, gDisplayBuffer[digit]);
+  }
+}
+
+void assertEffectFrames(const char *line, size_t expectedFrames) {
+  receiveLine(line);
+  TEST_ASSERT_TRUE(transitionRunning());
+  advanceFrames(expectedFrames - 1);
+  TEST_ASSERT_TRUE(transitionRunning());
+  advanceTransition();
+  TEST_ASSERT_FALSE(transitionRunning());
+  assertShowsLeftAligned("NEW");
+}
+
+} // namespace
+
+void setUp() {
+  releaseFrameStream();
+  gSerialMode = SerialMode::Text;
+  gPingPongState = PingPongState::None;
+  gScrollDirection = 1;
+  receiveLine("~H OLD");
+  framesUntilDone();
+  for (size_t step = 0; step < 2 * gScrollLimit; ++step) {
+    advanceScroll();
+  }
+}
+
+void tearDown() {}
+
+void test_cut_switches_without_an_effect() {
+  receiveLine("^C NEW");
+  TEST_ASSERT_FALSE(transitionRunning());
+  TEST_ASSERT_EQUAL(0, gScrollIndex);
+}
+
+void test_wipe_finishes_after_fixed_frames() {
+  assertEffectFrames("^W NEW", kWipeFrames);
+}
+
+void test_dissolve_finishes_after_fixed_frames() {
+  assertEffectFrames("^D NEW", kDissolveFrames);
+}
+
+void test_push_up_finishes_after_fixed_frames() {
+  assertEffectFrames("^U NEW", kPushUpFrames);
+}
+
+void test_dash_flip_finishes_after_fixed_frames() {
+  assertEffectFrames("^F NEW", kDashFlipFrames);
+}
+
+void test_scrolling_waits_for_the_effect() {
+  receiveLine("^W NEW");
+  const size_t index = gScrollIndex;
+  advanceFrames(kTransitionFramesPerStep);
+  advanceScroll();
+  TEST_ASSERT_EQUAL(index, gScrollIndex);
+
+  framesUntilDone();
+  advanceScroll();
+  TEST_ASSERT_NOT_EQUAL(index, gScrollIndex);
+}
+
+// A new line mid-effect starts its own effect from whatever is on display.
+void test_new_message_interrupts_running_effect() {
+  receiveLine("^D MID");
+  advanceFrames(kDissolveFrames / 2);
+  TEST_ASSERT_TRUE(transitionRunning());
+  uint8_t interrupted[kDisplayDigits];
+  memcpy(interrupted, gDisplayBuffer, sizeof(interrupted));
+
+  receiveLine("^W NEW");
+  TEST_ASSERT_TRUE(gTransitionEffect == TransitionEffect::Wipe);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(interrupted, gTransitionFrom, kDisplayDigits);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(interrupted, gDisplayBuffer, kDisplayDigits);
+  TEST_ASSERT_EQUAL(kWipeFrames, framesUntilDone());
+  assertShowsLeftAligned("NEW");
+}
+
+void test_cut_message_interrupts_running_effect() {
+  receiveLine("^F MID");
+  advanceFrames(kTransitionFramesPerStep);
+  TEST_ASSERT_TRUE(transitionRunning());
+
+  receiveLine("NEW");
+  TEST_ASSERT_FALSE(transitionRunning());
+  TEST_ASSERT_EQUAL(0, gScrollIndex);
+  assertShowsLeftAligned("");
+  advanceFrames(kDashFlipFrames);
+  assertShowsLeftAligned("");
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_cut_switches_without_an_effect);
+  RUN_TEST(test_wipe_finishes_after_fixed_frames);
+  RUN_TEST(test_dissolve_finishes_after_fixed_frames);
+  RUN_TEST(test_push_up_finishes_after_fixed_frames);
+  RUN_TEST(test_dash_flip_finishes_after_fixed_frames);
+  RUN_TEST(test_scrolling_waits_for_the_effect);
+  RUN_TEST(test_new_message_interrupts_running_effect);
+  RUN_TEST(test_cut_message_interrupts_running_effect);
+  return UNITY_END();
+}
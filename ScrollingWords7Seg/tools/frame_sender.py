@@ -0,0 +1,256 @@
+#!/usr/bin/env python3
+"""Stream raw segment frames to ScrollingWords7Seg over its binary protocol.
+
+Packets are COBS-encoded and terminated by 0x00. Decoded layout:
+[opcode][sequence][payload...][crc lo][crc hi], CRC-16/CCITT-FALSE over
+everything before the CRC. The firmware answers every packet with an ACK
+(0x80) or NAK (0x81) carrying the sequence number and a status byte. Frames
+that arrive after a newer one are acknowledged but not drawn.
+
+Requires pyserial (pip install pyserial).
+
+Examples:
+  frame_sender.py /dev/ttyACM0 --demo chase --fps 100 --seconds 10
+  frame_sender.py /dev/ttyACM0 --frame 3f 06 5b 4f 66 6d 7d 07
+  frame_sender.py /dev/ttyACM0 --brightness 64
+  frame_sender.py /dev/ttyACM0 --exit
+"""
+
+import argparse
+import collections
+import sys
+import time
+
+import serial
+
+DISPLAY_DIGITS = 8
+
+OP_SEGMENT_FRAME = 0x01
+OP_BRIGHTNESS = 0x02
+OP_RESUME_SCROLL = 0x03
+OP_EXIT_BINARY = 0x04
+OP_ACK = 0x80
+OP_NAK = 0x81
+
+STATUS_NAMES = {
+    0: "ok",
+    1: "bad crc",
+    2: "bad length",
+    3: "bad opcode",
+    4: "overflow",
+    5: "bad encoding",
+}
+# Framing error NAKs are not tied to a packet and always carry sequence 0;
+# the damaged packet is resent when its ACK times out.
+FRAMING_ERRORS = {4, 5}
+
+SEG_A, SEG_B, SEG_C, SEG_D, SEG_E, SEG_F, SEG_G = (1 << i for i in range(7))
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray(b"\x00")
+    code_index = 0
+    code = 1
+    for byte in data:
+        if byte:
+            out.append(byte)
+            code += 1
+        if not byte or code == 0xFF:
+            out[code_index] = code
+            code_index = len(out)
+            out.append(0)
+            code = 1
+    out[code_index] = code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    index = 0
+    while index < len(data):
+        code = data[index]
+        index += 1
+        if code == 0 or index + code - 1 > len(data):
+            raise ValueError("malformed COBS block")
+        out += data[index:index + code - 1]
+        index += code - 1
+        if code != 0xFF and index < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def build_packet(opcode, sequence, payload=b""):
+    body = bytes([opcode, sequence & 0xFF]) + bytes(payload)
+    crc = crc16(body)
+    return cobs_encode(body + bytes([crc & 0xFF, crc >> 8])) + b"\x00"
+
+
+class FrameLink:
+    """Sliding-window sender: keeps up to `window` packets awaiting an ACK."""
+
+    def __init__(self, port, baud, window, timeout):
+        self.serial = serial.Serial(port, baud, timeout=0)
+        self.window = window
+        self.timeout = timeout
+        self.sequence = 0
+        self.pending = collections.OrderedDict()
+        self.rx = bytearray()
+        self.acked = 0
+        self.naks = 0
+        self.retries = 0
+        # Opening the port resets most Megas; wait for the bootloader.
+        time.sleep(2.0)
+        self.serial.reset_input_buffer()
+        self.serial.write(b"\x00")  # Enter binary mode / resync
+
+    def send(self, opcode, payload=b""):
+        while len(self.pending) >= self.window:
+            self._poll()
+        sequence = self.sequence
+        self.sequence = (self.sequence + 1) & 0xFF
+        packet = build_packet(opcode, sequence, payload)
+        self.pending[sequence] = [packet, time.monotonic()]
+        self.serial.write(packet)
+        return sequence
+
+    def drain(self):
+        deadline = time.monotonic() + self.timeout * 4
+        while self.pending and time.monotonic() < deadline:
+            self._poll()
+        return not self.pending
+
+    def _poll(self):
+        self.rx += self.serial.read(self.serial.in_waiting or 1)
+        while b"\x00" in self.rx:
+            encoded, _, rest = self.rx.partition(b"\x00")
+            self.rx = bytearray(rest)
+            self._handle_response(encoded)
+
+        now = time.monotonic()
+        for sequence, entry in self.pending.items():
+            if now - entry[1] > self.timeout:
+                self._resend(sequence)
+
+    def _handle_response(self, encoded):
+        if not encoded:
+            return
+        try:
+            packet = cobs_decode(encoded)
+        except ValueError:
+            return  # Text output from the firmware, not a response packet
+        if len(packet) != 5 or crc16(packet[:3]) != (packet[3] | packet[4] << 8):
+            return
+        opcode, sequence, status = packet[0], packet[1], packet[2]
+        if opcode == OP_ACK:
+            if self.pending.pop(sequence, None) is not None:
+                self.acked += 1
+        elif opcode == OP_NAK:
+            self.naks += 1
+            print("NAK seq=%d: %s" % (sequence, STATUS_NAMES.get(status, status)),
+                  file=sys.stderr)
+            if status not in FRAMING_ERRORS and sequence in self.pending:
+                self._resend(sequence)
+
+    def _resend(self, sequence):
+        entry = self.pending[sequence]
+        entry[1] = time.monotonic()
+        self.retries += 1
+        self.serial.write(entry[0])
+
+
+def chase_frames():
+    ring = [SEG_A, SEG_B, SEG_C, SEG_D, SEG_E, SEG_F]
+    step = 0
+    while True:
+        frame = [0] * DISPLAY_DIGITS
+        frame[(step // len(ring)) % DISPLAY_DIGITS] = ring[step % len(ring)]
+        yield frame
+        step += 1
+
+
+def counter_frames():
+    digits = [0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F]
+    value = 0
+    while True:
+        text = str(value).rjust(DISPLAY_DIGITS)[-DISPLAY_DIGITS:]
+        yield [0 if c == " " else digits[int(c)] for c in text]
+        value += 1
+
+
+def sweep_frames():
+    mask = 1
+    while True:
+        yield [mask] * DISPLAY_DIGITS
+        mask = (mask << 1) if mask < SEG_G else 1
+
+
+DEMOS = {"chase": chase_frames, "counter": counter_frames, "sweep": sweep_frames}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--window", type=int, default=4,
+                        help="packets in flight before waiting for an ACK")
+    parser.add_argument("--timeout", type=float, default=0.1,
+                        help="seconds before an unacknowledged packet is resent")
+    action = parser.add_mutually_exclusive_group(required=True)
+    action.add_argument("--demo", choices=sorted(DEMOS))
+    action.add_argument("--frame", nargs=DISPLAY_DIGITS, metavar="HEX",
+                        help="one segment byte per digit, bit 0 = a")
+    action.add_argument("--brightness", type=int, metavar="0-255")
+    action.add_argument("--resume", action="store_true",
+                        help="hand the display back to the scrolling text")
+    action.add_argument("--exit", action="store_true",
+                        help="resume scrolling and return to text input")
+    parser.add_argument("--fps", type=float, default=100.0)
+    parser.add_argument("--seconds", type=float, default=10.0)
+    args = parser.parse_args()
+
+    link = FrameLink(args.port, args.baud, args.window, args.timeout)
+
+    if args.frame:
+        link.send(OP_SEGMENT_FRAME, bytes(int(b, 16) for b in args.frame))
+    elif args.brightness is not None:
+        link.send(OP_BRIGHTNESS, bytes([max(0, min(255, args.brightness))]))
+    elif args.resume:
+        link.send(OP_RESUME_SCROLL)
+    elif args.exit:
+        link.send(OP_EXIT_BINARY)
+    else:
+        period = 1.0 / args.fps
+        start = time.monotonic()
+        next_frame = start
+        frames = 0
+        for frame in DEMOS[args.demo]():
+            now = time.monotonic()
+            if now - start >= args.seconds:
+                break
+            if now < next_frame:
+                time.sleep(next_frame - now)
+            next_frame += period
+            link.send(OP_SEGMENT_FRAME, bytes(frame))
+            frames += 1
+        elapsed = time.monotonic() - start
+        print("sent %d frames in %.2f s (%.1f fps)" % (frames, elapsed,
+                                                       frames / elapsed))
+
+    if not link.drain():
+        print("%d packets never acknowledged" % len(link.pending), file=sys.stderr)
+    print("acked=%d nak=%d retries=%d" % (link.acked, link.naks, link.retries))
+    return 0 if not link.pending else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,55 @@
+#!/bin/sh
+# Builds the simavr images of every firmware and the harness, runs each image
+# and fails when a firmware exceeds its timing budget. Results are written to
+# results/<firmware>.json.
+#
+# Budgets are read from budgets.txt, one "<firmware> <budget options>" line
+# per firmware. "./run_all.sh --record" measures every firmware and rewrites
+# budgets.txt from the results with headroom; re-record after a deliberate
+# timing change. A firmware without a line fails the run until budgets.txt
+# has been recorded on a machine with simavr and committed.
+set -e
+cd "$(dirname "$0")"
+root=../..
+
+record=
+if [ "$1" = "--record" ]; then
+  record=1
+  rm -f budgets.txt.new
+fi
+
+pio run -e native
+mkdir -p results
+
+status=0
+run() {
+  firmware=$1
+  shift
+  if [ -n "$record" ]; then
+    budgets="--write-budgets budgets.txt.new"
+  else
+    budgets=
+    [ -f budgets.txt ] && budgets=$(sed -n "s/^$firmware //p" budgets.txt)
+    if [ -z "$budgets" ]; then
+      echo "$firmware: no budgets.txt line; run ./run_all.sh --record" \
+        "and commit budgets.txt" >&2
+      status=1
+      return
+    fi
+  fi
+  pio run -d "$root/$firmware" -e megaatmega2560_sim
+  # shellcheck disable=SC2086 # budgets holds several options
+  .pio/build/native/program --firmware "$firmware" \
+    --elf "$root/$firmware/.pio/build/megaatmega2560_sim/firmware.elf" \
+    --json "results/$firmware.json" "$@" $budgets || status=1
+}
+
+run ScrollingWords7Seg --seconds 5 --serial-script scripts/scrolling.txt
+run ArduinoTest --seconds 3
+# One loop() pass runs the whole segment sweep and pattern cycle (~12 s).
+run 7segtester --seconds 26
+
+if [ -n "$record" ] && [ $status -eq 0 ]; then
+  mv budgets.txt.new budgets.txt
+fi
+exit $status
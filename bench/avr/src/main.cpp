@@ -0,0 +1,666 @@
+// Runs a firmware image under simavr and derives timing figures from the
+// simulated GPIO timeline: loop() pass length (from the BenchLoopMarker pin
+// into the megaatmega2560_sim images), digit multiplexing period and blanking
+// gap, full-frame refresh rate and jitter of visible content steps. Serial
+// input can be scripted, and per-firmware budgets turn the figures into a
+// pass/fail result; --write-budgets derives those budgets from a run.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <BenchLoopMarker.h>
+
+#include "avr_ioport.h"
+#include "avr_uart.h"
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_io.h"
+#include "sim_irq.h"
+
+namespace {
+
+constexpr uint32_t kCpuFrequency = 16000000;
+constexpr uint32_t kSerialBaud = 115200;
+constexpr uint64_t kCyclesPerSerialByte = (kCpuFrequency * 10ull) / kSerialBaud;
+constexpr uint8_t kLoopMarkerPin = BENCH_LOOP_MARKER_PIN;
+constexpr size_t kMaxPins = 8;
+// --write-budgets allows this much over (or under, for the refresh rate) the
+// figures of the run it records, plus kBudgetSlackUs for timing budgets.
+constexpr double kBudgetHeadroom = 1.25;
+constexpr double kBudgetSlackUs = 50.0;
+
+struct PinRef {
+  char port;
+  uint8_t bit;
+};
+
+struct MegaPin {
+  uint8_t arduinoPin;
+  PinRef ref;
+};
+
+// Arduino Mega 2560 pin numbers used by the firmwares.
+constexpr MegaPin kMegaPins[] = {
+    {2, {'E', 4}},  {3, {'E', 5}},  {4, {'G', 5}},  {5, {'E', 3}},
+    {6, {'H', 3}},  {7, {'H', 4}},  {8, {'H', 5}},  {9, {'H', 6}},
+    {10, {'B', 4}}, {11, {'B', 5}}, {12, {'B', 6}}, {13, {'B', 7}},
+    {22, {'A', 0}}, {24, {'A', 2}}, {26, {'A', 4}}, {28, {'A', 6}},
+    {42, {'L', 7}},
+};
+
+struct FirmwareProfile {
+  const char *name;
+  uint8_t digitPins[kMaxPins];
+  size_t digitCount;
+  bool digitsActiveHigh;
+  uint8_t segmentPins[kMaxPins];
+  size_t segmentCount;
+  bool segmentsActiveHigh;
+  double stepPeriodMs; // Visible content only changes on multiples of this
+};
+
+constexpr FirmwareProfile kProfiles[] = {
+    {"ScrollingWords7Seg", {9, 10, 11, 12, 22, 24, 26, 28}, 8, true,
+     {2, 3, 4, 5, 6, 7, 8}, 7, false, 250.0},
+    {"ArduinoTest", {9, 10, 11, 12}, 4, true,
+     {2, 3, 4, 5, 6, 7, 8}, 7, false, 20.0},
+    // 200 ms segment sweep steps and 1500 ms pattern holds share 100 ms.
+    {"7segtester", {10, 11, 12, 13}, 4, false,
+     {2, 3, 4, 5, 6, 7, 8, 9}, 8, true, 100.0},
+};
+
+struct Stats {
+  uint64_t count = 0;
+  double sum = 0;
+  double min = 0;
+  double max = 0;
+
+  void add(double value) {
+    if (count == 0 || value < min) {
+      min = value;
+    }
+    if (count == 0 || value > max) {
+      max = value;
+    }
+    sum += value;
+    ++count;
+  }
+
+  double mean() const { return (count > 0) ? sum / count : 0; }
+};
+
+struct Budgets {
+  double maxLoopUs = 0;
+  double maxDigitPeriodUs = 0;
+  double minRefreshHz = 0;
+  double maxStepJitterUs = 0;
+};
+
+// A visible content step lies between the last digit enable that still showed
+// the old pattern and the first enable showing the new one.
+struct StepWindow {
+  uint64_t earliest;
+  uint64_t latest;
+};
+
+struct SerialByte {
+  uint64_t cycle;
+  uint8_t value;
+};
+
+struct Bench;
+
+struct PinWatch {
+  Bench *bench;
+  enum class Kind : uint8_t { Digit, Segment, LoopMarker } kind;
+  size_t index;
+};
+
+struct Bench {
+  avr_t *avr = nullptr;
+  const FirmwareProfile *profile = nullptr;
+  uint64_t warmupCycles = 0;
+  bool echoSerial = false;
+
+  bool digitOn[kMaxPins] = {};
+  uint8_t segments = 0;
+  uint8_t shownPattern[kMaxPins] = {};
+  uint64_t lastShownCycle[kMaxPins] = {};
+  PinWatch watches[2 * kMaxPins + 1] = {};
+
+  bool haveDigitOn = false;
+  uint64_t lastDigitOnCycle = 0;
+  bool blanking = false;
+  uint64_t lastDigitOffCycle = 0;
+  uint64_t digitEnables = 0;
+
+  bool haveStep = false;
+  StepWindow step = {};
+  uint64_t lastChangeCycle = 0;
+  bool havePreviousStep = false;
+  StepWindow previousStep = {};
+
+  bool haveMarker = false;
+  uint64_t lastMarkerCycle = 0;
+
+  Stats loopCycles;
+  Stats digitPeriod;
+  Stats blankGap;
+  Stats stepInterval;
+  double maxStepDeviationCycles = 0;
+
+  std::vector<SerialByte> serialInput;
+  size_t serialInputIndex = 0;
+  avr_irq_t *uartInput = nullptr;
+  std::string serialLine;
+};
+
+double cyclesToUs(double cycles) { return cycles * 1e6 / kCpuFrequency; }
+
+uint64_t msToCycles(double ms) {
+  return static_cast<uint64_t>(ms * kCpuFrequency / 1000.0);
+}
+
+bool findMegaPin(uint8_t arduinoPin, PinRef &ref) {
+  for (const auto &pin : kMegaPins) {
+    if (pin.arduinoPin == arduinoPin) {
+      ref = pin.ref;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Deviation of the interval between two steps from a whole number of step
+// periods, beyond what the uncertainty of their windows can explain.
+uint64_t stepDeviation(const StepWindow &from, const StepWindow &to,
+                       uint64_t stepCycles) {
+  const uint64_t shortest =
+      (to.earliest > from.latest) ? to.earliest - from.latest : 0;
+  const uint64_t longest = to.latest - from.earliest;
+  const uint64_t below = (shortest / stepCycles) * stepCycles;
+  const uint64_t above = below + stepCycles;
+  if (below == shortest || above <= longest) {
+    return 0;
+  }
+  const uint64_t late = shortest - below;
+  const uint64_t early = above - longest;
+  return (late < early) ? late : early;
+}
+
+void closeStep(Bench &bench) {
+  if (!bench.haveStep) {
+    return;
+  }
+  bench.haveStep = false;
+
+  if (bench.havePreviousStep) {
+    const uint64_t stepCycles = msToCycles(bench.profile->stepPeriodMs);
+    bench.stepInterval.add(
+        static_cast<double>(bench.step.latest - bench.previousStep.latest));
+    const double deviation = static_cast<double>(
+        stepDeviation(bench.previousStep, bench.step, stepCycles));
+    if (deviation > bench.maxStepDeviationCycles) {
+      bench.maxStepDeviationCycles = deviation;
+    }
+  }
+  bench.havePreviousStep = true;
+  bench.previousStep = bench.step;
+}
+
+// Serial input restarts the message and its step timing, so steps are only
+// compared within stretches without input.
+void restartStepTracking(Bench &bench) {
+  closeStep(bench);
+  bench.havePreviousStep = false;
+}
+
+void recordContentChange(Bench &bench, uint64_t earliest, uint64_t cycle) {
+  const uint64_t stepCycles = msToCycles(bench.profile->stepPeriodMs);
+  // A step reaches the digits one at a time. A digit that still showed its
+  // old pattern after the step's first change belongs to a later step.
+  const bool sameStep = bench.haveStep && earliest <= bench.step.latest &&
+                        (cycle - bench.lastChangeCycle) <= stepCycles / 2;
+  bench.lastChangeCycle = cycle;
+  if (sameStep) {
+    if (earliest > bench.step.earliest) {
+      bench.step.earliest = earliest;
+    }
+    return;
+  }
+
+  closeStep(bench);
+  bench.haveStep = true;
+  bench.step = {earliest, cycle};
+}
+
+void onDigitChange(Bench &bench, size_t digit, bool on, uint64_t cycle) {
+  if (bench.digitOn[digit] == on) {
+    return;
+  }
+  bench.digitOn[digit] = on;
+
+  if (!on) {
+    bench.blanking = true;
+    bench.lastDigitOffCycle = cycle;
+    return;
+  }
+
+  ++bench.digitEnables;
+  if (bench.haveDigitOn) {
+    bench.digitPeriod.add(static_cast<double>(cycle - bench.lastDigitOnCycle));
+  }
+  if (bench.blanking) {
+    bench.blankGap.add(static_cast<double>(cycle - bench.lastDigitOffCycle));
+    bench.blanking = false;
+  }
+  bench.haveDigitOn = true;
+  bench.lastDigitOnCycle = cycle;
+
+  if (bench.shownPattern[digit] != bench.segments) {
+    bench.shownPattern[digit] = bench.segments;
+    recordContentChange(bench, bench.lastShownCycle[digit], cycle);
+  }
+  bench.lastShownCycle[digit] = cycle;
+}
+
+void onPinChange(avr_irq_t *, uint32_t value, void *param) {
+  PinWatch &watch = *static_cast<PinWatch *>(param);
+  Bench &bench = *watch.bench;
+  const uint64_t cycle = bench.avr->cycle;
+  const FirmwareProfile &profile = *bench.profile;
+
+  if (watch.kind == PinWatch::Kind::Segment) {
+    const bool on = (value != 0) == profile.segmentsActiveHigh;
+    const uint8_t mask = static_cast<uint8_t>(1u << watch.index);
+    bench.segments = on ? (bench.segments | mask) : (bench.segments & ~mask);
+    return;
+  }
+
+  if (cycle < bench.warmupCycles) {
+    if (watch.kind == PinWatch::Kind::Digit) {
+      const bool on = (value != 0) == profile.digitsActiveHigh;
+      bench.digitOn[watch.index] = on;
+      if (on) {
+        bench.shownPattern[watch.index] = bench.segments;
+        bench.lastShownCycle[watch.index] = cycle;
+      }
+    }
+    return;
+  }
+
+  if (watch.kind == PinWatch::Kind::LoopMarker) {
+    if (bench.haveMarker) {
+      bench.loopCycles.add(static_cast<double>(cycle - bench.lastMarkerCycle));
+    }
+    bench.haveMarker = true;
+    bench.lastMarkerCycle = cycle;
+    return;
+  }
+
+  onDigitChange(bench, watch.index, (value != 0) == profile.digitsActiveHigh,
+                cycle);
+}
+
+void onSerialOutput(avr_irq_t *, uint32_t value, void *param) {
+  Bench &bench = *static_cast<Bench *>(param);
+  const char c = static_cast<char>(value);
+  if (c == '\n') {
+    if (bench.echoSerial) {
+      printf("  serial> %s\n", bench.serialLine.c_str());
+    }
+    bench.serialLine.clear();
+  } else if (c != '\r') {
+    bench.serialLine += c;
+  }
+}
+
+avr_cycle_count_t feedSerialInput(avr_t *, avr_cycle_count_t, void *param) {
+  Bench &bench = *static_cast<Bench *>(param);
+  if (bench.serialInputIndex >= bench.serialInput.size()) {
+    return 0;
+  }
+  restartStepTracking(bench);
+  avr_raise_irq(bench.uartInput,
+                bench.serialInput[bench.serialInputIndex++].value);
+  return (bench.serialInputIndex < bench.serialInput.size())
+             ? bench.serialInput[bench.serialInputIndex].cycle
+             : 0;
+}
+
+bool watchPin(Bench &bench, uint8_t arduinoPin, PinWatch &watch) {
+  PinRef ref;
+  if (!findMegaPin(arduinoPin, ref)) {
+    fprintf(stderr, "no port mapping for pin %u\n", arduinoPin);
+    return false;
+  }
+  avr_irq_t *irq =
+      avr_io_getirq(bench.avr, AVR_IOCTL_IOPORT_GETIRQ(ref.port), ref.bit);
+  if (irq == nullptr) {
+    fprintf(stderr, "no IRQ for port %c bit %u\n", ref.port, ref.bit);
+    return false;
+  }
+  avr_irq_register_notify(irq, onPinChange, &watch);
+  return true;
+}
+
+// Script lines are "<time_ms> <text>"; text accepts \n, \r, \\ and \xNN.
+// Bytes are paced at the serial baud rate, starting no earlier than time_ms.
+bool loadSerialScript(const char *path, Bench &bench) {
+  FILE *file = fopen(path, "r");
+  if (file == nullptr) {
+    fprintf(stderr, "cannot open serial script %s\n", path);
+    return false;
+  }
+
+  char line[512];
+  uint64_t nextCycle = 0;
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    char *text = nullptr;
+    const double timeMs = strtod(line, &text);
+    if (text == line || line[0] == '#') {
+      continue;
+    }
+    if (*text == ' ') {
+      ++text;
+    }
+
+    uint64_t cycle = msToCycles(timeMs);
+    if (cycle < nextCycle) {
+      cycle = nextCycle;
+    }
+    for (const char *c = text; *c != '\0' && *c != '\n'; ++c) {
+      uint8_t value = static_cast<uint8_t>(*c);
+      if (*c == '\\' && c[1] != '\0') {
+        ++c;
+        if (*c == 'n') {
+          value = '\n';
+        } else if (*c == 'r') {
+          value = '\r';
+        } else if (*c == 'x' && c[1] != '\0' && c[2] != '\0') {
+          const char hex[3] = {c[1], c[2], '\0'};
+          value = static_cast<uint8_t>(strtoul(hex, nullptr, 16));
+          c += 2;
+        } else {
+          value = static_cast<uint8_t>(*c);
+        }
+      }
+      bench.serialInput.push_back({cycle, value});
+      cycle += kCyclesPerSerialByte;
+    }
+    nextCycle = cycle;
+  }
+
+  fclose(file);
+  return true;
+}
+
+const FirmwareProfile *findProfile(const char *name) {
+  for (const auto &profile : kProfiles) {
+    if (strcmp(profile.name, name) == 0) {
+      return &profile;
+    }
+  }
+  return nullptr;
+}
+
+bool checkBudget(const char *label, double value, double limit, bool isMax) {
+  if (limit <= 0) {
+    return true;
+  }
+  const bool ok = isMax ? value <= limit : value >= limit;
+  printf("  budget %-22s %12.2f %s %-10.2f %s\n", label, value,
+         isMax ? "<=" : ">=", limit, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// Appends "<firmware> <budget options>" for run_all.sh to pass back later.
+bool writeBudgets(const char *path, const char *firmware,
+                  const Budgets &measured) {
+  FILE *file = fopen(path, "a");
+  if (file == nullptr) {
+    return false;
+  }
+  fprintf(file,
+          "%s --max-loop-us %.0f --max-digit-period-us %.0f "
+          "--min-refresh-hz %.0f --max-step-jitter-us %.0f\n",
+          firmware, ceil(measured.maxLoopUs * kBudgetHeadroom + kBudgetSlackUs),
+          ceil(measured.maxDigitPeriodUs * kBudgetHeadroom + kBudgetSlackUs),
+          floor(measured.minRefreshHz / kBudgetHeadroom),
+          ceil(measured.maxStepJitterUs * kBudgetHeadroom + kBudgetSlackUs));
+  return fclose(file) == 0;
+}
+
+void writeStats(FILE *file, const char *name, const Stats &stats, bool last) {
+  fprintf(file,
+          "    \"%s\": {\"count\": %llu, \"min_us\": %.3f, \"mean_us\": %.3f, "
+          "\"max_us\": %.3f}%s\n",
+          name, static_cast<unsigned long long>(stats.count),
+          cyclesToUs(stats.min), cyclesToUs(stats.mean()),
+          cyclesToUs(stats.max), last ? "" : ",");
+}
+
+void printStats(const char *label, const Stats &stats) {
+  if (stats.count == 0) {
+    printf("  %-22s (no samples)\n", label);
+    return;
+  }
+  printf("  %-22s min %10.2f  mean %10.2f  max %10.2f us  (%llu samples)\n",
+         label, cyclesToUs(stats.min), cyclesToUs(stats.mean()),
+         cyclesToUs(stats.max), static_cast<unsigned long long>(stats.count));
+}
+
+void usage(const char *program) {
+  fprintf(stderr,
+          "usage: %s --firmware NAME --elf PATH [options]\n"
+          "  --firmware NAME            ScrollingWords7Seg, ArduinoTest or "
+          "7segtester\n"
+          "  --elf PATH                 megaatmega2560_sim firmware.elf\n"
+          "  --seconds N                simulated run time (default 5)\n"
+          "  --warmup-ms N              ignore the first N ms (default 100)\n"
+          "  --serial-script PATH       scripted serial input\n"
+          "  --json PATH                write results as JSON\n"
+          "  --echo-serial              print firmware serial output\n"
+          "  --write-budgets PATH       append budgets derived from this run\n"
+          "  --max-loop-us N            budget: longest loop() pass\n"
+          "  --max-digit-period-us N    budget: longest digit-to-digit switch\n"
+          "  --min-refresh-hz N         budget: full-frame refresh rate\n"
+          "  --max-step-jitter-us N     budget: content step deviation\n",
+          program);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const char *firmwareName = nullptr;
+  const char *elfPath = nullptr;
+  const char *scriptPath = nullptr;
+  const char *jsonPath = nullptr;
+  const char *budgetsPath = nullptr;
+  double seconds = 5.0;
+  double warmupMs = 100.0;
+  bool echoSerial = false;
+  Budgets budgets;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const bool hasValue = (i + 1) < argc;
+    if (arg == "--echo-serial") {
+      echoSerial = true;
+    } else if (arg == "--firmware" && hasValue) {
+      firmwareName = argv[++i];
+    } else if (arg == "--elf" && hasValue) {
+      elfPath = argv[++i];
+    } else if (arg == "--serial-script" && hasValue) {
+      scriptPath = argv[++i];
+    } else if (arg == "--json" && hasValue) {
+      jsonPath = argv[++i];
+    } else if (arg == "--write-budgets" && hasValue) {
+      budgetsPath = argv[++i];
+    } else if (arg == "--seconds" && hasValue) {
+      seconds = atof(argv[++i]);
+    } else if (arg == "--warmup-ms" && hasValue) {
+      warmupMs = atof(argv[++i]);
+    } else if (arg == "--max-loop-us" && hasValue) {
+      budgets.maxLoopUs = atof(argv[++i]);
+    } else if (arg == "--max-digit-period-us" && hasValue) {
+      budgets.maxDigitPeriodUs = atof(argv[++i]);
+    } else if (arg == "--min-refresh-hz" && hasValue) {
+      budgets.minRefreshHz = atof(argv[++i]);
+    } else if (arg == "--max-step-jitter-us" && hasValue) {
+      budgets.maxStepJitterUs = atof(argv[++i]);
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  const FirmwareProfile *profile =
+      (firmwareName != nullptr) ? findProfile(firmwareName) : nullptr;
+  if (profile == nullptr || elfPath == nullptr) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  elf_firmware_t firmware;
+  memset(&firmware, 0, sizeof(firmware));
+  if (elf_read_firmware(elfPath, &firmware) != 0) {
+    fprintf(stderr, "cannot read %s\n", elfPath);
+    return 1;
+  }
+  strcpy(firmware.mmcu, "atmega2560");
+  firmware.frequency = kCpuFrequency;
+
+  static Bench bench;
+  bench.avr = avr_make_mcu_by_name(firmware.mmcu);
+  if (bench.avr == nullptr) {
+    fprintf(stderr, "simavr has no atmega2560 core\n");
+    return 1;
+  }
+  avr_init(bench.avr);
+  avr_load_firmware(bench.avr, &firmware);
+  bench.profile = profile;
+  bench.warmupCycles = msToCycles(warmupMs);
+  bench.echoSerial = echoSerial;
+
+  size_t watchIndex = 0;
+  bool pinsOk = true;
+  for (size_t i = 0; i < profile->digitCount; ++i) {
+    PinWatch &watch = bench.watches[watchIndex++];
+    watch = {&bench, PinWatch::Kind::Digit, i};
+    pinsOk &= watchPin(bench, profile->digitPins[i], watch);
+  }
+  for (size_t i = 0; i < profile->segmentCount; ++i) {
+    PinWatch &watch = bench.watches[watchIndex++];
+    watch = {&bench, PinWatch::Kind::Segment, i};
+    pinsOk &= watchPin(bench, profile->segmentPins[i], watch);
+  }
+  PinWatch &marker = bench.watches[watchIndex++];
+  marker = {&bench, PinWatch::Kind::LoopMarker, 0};
+  pinsOk &= watchPin(bench, kLoopMarkerPin, marker);
+  if (!pinsOk) {
+    return 1;
+  }
+
+  uint32_t uartFlags = 0;
+  avr_ioctl(bench.avr, AVR_IOCTL_UART_GET_FLAGS('0'), &uartFlags);
+  uartFlags &= ~AVR_UART_FLAG_STDIO;
+  avr_ioctl(bench.avr, AVR_IOCTL_UART_SET_FLAGS('0'), &uartFlags);
+  avr_irq_register_notify(
+      avr_io_getirq(bench.avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT),
+      onSerialOutput, &bench);
+  bench.uartInput =
+      avr_io_getirq(bench.avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+
+  if (scriptPath != nullptr && !loadSerialScript(scriptPath, bench)) {
+    return 1;
+  }
+  if (!bench.serialInput.empty()) {
+    avr_cycle_timer_register(bench.avr, bench.serialInput.front().cycle,
+                             feedSerialInput, &bench);
+  }
+
+  const uint64_t endCycle = msToCycles(seconds * 1000.0);
+  int state = cpu_Running;
+  while (bench.avr->cycle < endCycle) {
+    state = avr_run(bench.avr);
+    if (state == cpu_Done || state == cpu_Crashed) {
+      break;
+    }
+  }
+  if (state == cpu_Crashed) {
+    fprintf(stderr, "%s: simulated CPU crashed at cycle %llu\n", profile->name,
+            static_cast<unsigned long long>(bench.avr->cycle));
+    return 1;
+  }
+  closeStep(bench);
+
+  const double measuredSeconds =
+      static_cast<double>(bench.avr->cycle - bench.warmupCycles) /
+      kCpuFrequency;
+  const double refreshHz =
+      (measuredSeconds > 0)
+          ? (bench.digitEnables / static_cast<double>(profile->digitCount)) /
+                measuredSeconds
+          : 0;
+  const double stepJitterUs = cyclesToUs(bench.maxStepDeviationCycles);
+
+  printf("%s (%.2f s simulated, %llu cycles)\n", profile->name,
+         measuredSeconds, static_cast<unsigned long long>(bench.avr->cycle));
+  printStats("loop() pass", bench.loopCycles);
+  printStats("digit switch period", bench.digitPeriod);
+  printStats("digit blanking gap", bench.blankGap);
+  printStats("content step interval", bench.stepInterval);
+  printf("  %-22s %10.2f Hz\n", "frame refresh rate", refreshHz);
+  printf("  %-22s %10.2f us (nominal step %.0f ms, beyond multiplex latency)\n",
+         "step jitter",
+         stepJitterUs, profile->stepPeriodMs);
+
+  if (jsonPath != nullptr) {
+    FILE *file = fopen(jsonPath, "w");
+    if (file == nullptr) {
+      fprintf(stderr, "cannot write %s\n", jsonPath);
+      return 1;
+    }
+    fprintf(file,
+            "{\n  \"firmware\": \"%s\",\n  \"simulated_seconds\": %.3f,\n",
+            profile->name, measuredSeconds);
+    fprintf(file, "  \"refresh_hz\": %.3f,\n  \"step_jitter_us\": %.3f,\n",
+            refreshHz, stepJitterUs);
+    fprintf(file, "  \"timing\": {\n");
+    writeStats(file, "loop_pass", bench.loopCycles, false);
+    writeStats(file, "digit_period", bench.digitPeriod, false);
+    writeStats(file, "blanking_gap", bench.blankGap, false);
+    writeStats(file, "step_interval", bench.stepInterval, true);
+    fprintf(file, "  }\n}\n");
+    fclose(file);
+  }
+
+  Budgets measured;
+  measured.maxLoopUs = cyclesToUs(bench.loopCycles.max);
+  measured.maxDigitPeriodUs = cyclesToUs(bench.digitPeriod.max);
+  measured.minRefreshHz = refreshHz;
+  measured.maxStepJitterUs = stepJitterUs;
+  if (budgetsPath != nullptr &&
+      !writeBudgets(budgetsPath, profile->name, measured)) {
+    fprintf(stderr, "cannot write %s\n", budgetsPath);
+    return 1;
+  }
+
+  bool withinBudget = true;
+  withinBudget &= checkBudget("loop() pass us", measured.maxLoopUs,
+                              budgets.maxLoopUs, true);
+  withinBudget &= checkBudget("digit period us", measured.maxDigitPeriodUs,
+                              budgets.maxDigitPeriodUs, true);
+  withinBudget &= checkBudget("refresh Hz", measured.minRefreshHz,
+                              budgets.minRefreshHz, false);
+  withinBudget &= checkBudget("step jitter us", measured.maxStepJitterUs,
+                              budgets.maxStepJitterUs, true);
+  return withinBudget ? 0 : 1;
+}
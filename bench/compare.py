@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+"""Compare two host benchmark result files and flag regressions.
+
+  compare.py base.json candidate.json [--threshold PERCENT]
+
+Exits non-zero when any benchmark slowed down by more than the threshold or
+started allocating.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as handle:
+        return {entry["name"]: entry for entry in json.load(handle)["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("base")
+    parser.add_argument("candidate")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="allowed ns/op increase in percent (default 10)")
+    args = parser.parse_args()
+
+    base = load(args.base)
+    candidate = load(args.candidate)
+    regressions = 0
+
+    print("%-44s %12s %12s %8s" % ("benchmark", "base ns", "new ns", "delta"))
+    for name in sorted(set(base) | set(candidate)):
+        if name not in base or name not in candidate:
+            print("%-44s %s" % (name, "only in " +
+                                ("base" if name in base else "candidate")))
+            continue
+        old, new = base[name], candidate[name]
+        delta = (new["ns_per_op"] - old["ns_per_op"]) / old["ns_per_op"] * 100
+        flags = []
+        if delta > args.threshold:
+            flags.append("SLOWER")
+        if new["allocs_per_op"] > old["allocs_per_op"]:
+            flags.append("ALLOCS %.3f -> %.3f" % (old["allocs_per_op"],
+                                                  new["allocs_per_op"]))
+        regressions += bool(flags)
+        print("%-44s %12.2f %12.2f %+7.1f%% %s" % (
+            name, old["ns_per_op"], new["ns_per_op"], delta, " ".join(flags)))
+
+    if regressions:
+        print("%d regression(s) over %.1f%%" % (regressions, args.threshold))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,79 @@
+// Minimal host stand-in for the Arduino core so the firmware sources can be
+// compiled natively for benchmarking and host tests. Pin writes are no-ops,
+// Serial has no input and keeps only the bytes of its last write().
+#pragma once
+
+#include <ctype.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+
+#define F(string_literal) (string_literal)
+#define PROGMEM
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define constrain(amt, low, high)                                              \
+  ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// PROGMEM reads: flash and RAM share one address space on the host. The
+// word reads assume a little-endian host, as AVR is.
+inline uint8_t pgm_read_byte(const void *address) {
+  return *static_cast<const uint8_t *>(address);
+}
+
+inline uint16_t pgm_read_word(const void *address) {
+  uint16_t value;
+  memcpy(&value, address, sizeof(value));
+  return value;
+}
+
+inline uint32_t pgm_read_dword(const void *address) {
+  uint32_t value;
+  memcpy(&value, address, sizeof(value));
+  return value;
+}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline void delayMicroseconds(unsigned int) {}
+
+inline unsigned long micros() {
+  static const auto start = std::chrono::steady_clock::now();
+  return static_cast<unsigned long>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count());
+}
+
+inline unsigned long millis() { return micros() / 1000; }
+
+class HostSerial {
+public:
+  void begin(unsigned long) {}
+  int available() { return 0; }
+  int read() { return -1; }
+  int availableForWrite() { return 63; }
+  size_t write(uint8_t) { return 1; }
+  size_t write(const uint8_t *data, size_t length) {
+    lastWriteLength =
+        (length < sizeof(lastWrite)) ? length : sizeof(lastWrite);
+    memcpy(lastWrite, data, lastWriteLength);
+    return length;
+  }
+  template <typename T> size_t print(const T &) { return 0; }
+  template <typename T> size_t println(const T &) { return 0; }
+  size_t println() { return 0; }
+
+  uint8_t lastWrite[32] = {};
+  size_t lastWriteLength = 0;
+};
+
+extern HostSerial Serial;
@@ -0,0 +1,89 @@
+// Lightweight benchmark harness: auto-calibrated iteration counts, median of
+// several runs, heap allocation counting and JSON output for comparing runs.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// Incremented by the global operator new replacements in main.cpp.
+extern size_t gAllocationCount;
+
+template <typename T> inline void doNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobberMemory() { asm volatile("" : : : "memory"); }
+
+struct Result {
+  std::string name;
+  uint64_t iterations;
+  size_t itemsPerOp;
+  double nsPerOp;
+  double nsPerItem;
+  double allocsPerOp;
+};
+
+constexpr double kMinRunNanos = 50e6; // Calibrate each run to >= 50 ms
+constexpr int kRuns = 5;
+
+std::vector<Result> &results();
+
+template <typename Fn> double timeIterations(Fn &fn, uint64_t iterations) {
+  const auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < iterations; ++i) {
+    fn();
+    clobberMemory();
+  }
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// Runs fn() repeatedly and records the median time per call. itemsPerOp is
+// the number of elements one call processes, used for the per-item figure.
+template <typename Fn>
+void run(const std::string &name, size_t itemsPerOp, Fn fn) {
+  uint64_t iterations = 1;
+  for (;;) {
+    const double elapsed = timeIterations(fn, iterations);
+    if (elapsed >= kMinRunNanos || iterations >= (1ull << 40)) {
+      break;
+    }
+    const double scale = (elapsed > 0) ? (kMinRunNanos * 1.2 / elapsed) : 10;
+    iterations = static_cast<uint64_t>(
+        iterations * std::min(std::max(scale, 1.5), 100.0));
+  }
+
+  std::vector<double> samples;
+  samples.reserve(kRuns);
+  const size_t allocationsBefore = gAllocationCount;
+  for (int runIndex = 0; runIndex < kRuns; ++runIndex) {
+    samples.push_back(timeIterations(fn, iterations) / iterations);
+  }
+  const size_t allocations = gAllocationCount - allocationsBefore;
+  std::sort(samples.begin(), samples.end());
+
+  Result result;
+  result.name = name;
+  result.iterations = iterations;
+  result.itemsPerOp = (itemsPerOp > 0) ? itemsPerOp : 1;
+  result.nsPerOp = samples[samples.size() / 2];
+  result.nsPerItem = result.nsPerOp / result.itemsPerOp;
+  result.allocsPerOp = static_cast<double>(allocations) /
+                       (static_cast<double>(iterations) * kRuns);
+  results().push_back(result);
+
+  printf("%-44s %12.2f ns/op %10.3f ns/item %8.3f allocs/op\n", name.c_str(),
+         result.nsPerOp, result.nsPerItem, result.allocsPerOp);
+}
+
+bool writeJson(const char *path);
+
+} // namespace bench
@@ -0,0 +1,249 @@
+// Host microbenchmarks for the display pipeline hot paths of all three
+// firmwares. Each firmware is compiled into its own namespace so their
+// setup()/loop() and shared names do not collide.
+
+#include <Arduino.h>
+#include <SegmentStrip.h>
+#include <ctype.h>
+#include <string.h>
+
+#include <new>
+#include <string>
+
+#include "bench.h"
+
+HostSerial Serial;
+
+namespace scrolling {
+#include "../../../ScrollingWords7Seg/src/main.cpp"
+} // namespace scrolling
+
+namespace counter {
+#include "../../../ArduinoTest/src/main.cpp"
+} // namespace counter
+
+namespace tester {
+#include "../../../7segtester/src/main.cpp"
+} // namespace tester
+
+namespace bench {
+
+size_t gAllocationCount = 0;
+
+std::vector<Result> &results() {
+  static std::vector<Result> allResults;
+  return allResults;
+}
+
+bool writeJson(const char *path) {
+  FILE *file = fopen(path, "w");
+  if (file == nullptr) {
+    return false;
+  }
+
+  fprintf(file, "{\n  \"compiler\": \"%s\",\n  \"benchmarks\": [\n",
+          __VERSION__);
+  for (size_t i = 0; i < results().size(); ++i) {
+    const Result &result = results()[i];
+    fprintf(file,
+            "    {\"name\": \"%s\", \"iterations\": %llu, "
+            "\"items_per_op\": %zu, \"ns_per_op\": %.4f, "
+            "\"ns_per_item\": %.4f, \"allocs_per_op\": %.4f}%s\n",
+            result.name.c_str(),
+            static_cast<unsigned long long>(result.iterations),
+            result.itemsPerOp, result.nsPerOp, result.nsPerItem,
+            result.allocsPerOp, (i + 1 < results().size()) ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+  return fclose(file) == 0;
+}
+
+} // namespace bench
+
+void *operator new(size_t size) {
+  ++bench::gAllocationCount;
+  if (void *memory = malloc(size ? size : 1)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *memory) noexcept { free(memory); }
+void operator delete[](void *memory) noexcept { free(memory); }
+void operator delete(void *memory, size_t) noexcept { free(memory); }
+void operator delete[](void *memory, size_t) noexcept { free(memory); }
+
+namespace {
+
+constexpr size_t kMessageLengths[] = {0, 1, 4, 8, 16, 32, 64};
+constexpr size_t kAsciiCount = 128;
+
+// Representative text: letters, digits, spaces and unsupported glyphs.
+std::string sampleMessage(size_t length) {
+  static const char kPattern[] = "HELLO 7SEG world 0123456789 -_ KMQVWXZ!";
+  std::string message;
+  for (size_t i = 0; i < length; ++i) {
+    message += kPattern[i % (sizeof(kPattern) - 1)];
+  }
+  return message;
+}
+
+void benchEncodeChar() {
+  bench::run("encodeChar/ascii_0_127", kAsciiCount, [] {
+    for (size_t c = 0; c < kAsciiCount; ++c) {
+      bench::doNotOptimize(scrolling::encodeChar(static_cast<char>(c)));
+    }
+  });
+}
+
+// Keeps the buildPaddedMessage/ names from before the function was renamed so
+// compare.py can still line results up across commits.
+void benchEncodeMessage() {
+  for (size_t length : kMessageLengths) {
+    const std::string message = sampleMessage(length);
+    memcpy(scrolling::gMessage, message.data(), length);
+    scrolling::gMessage[length] = '\0';
+    scrolling::gMessageLength = length;
+    bench::run("buildPaddedMessage/len_" + std::to_string(length), length,
+               [] {
+                 scrolling::gScrollIndex = 0;
+                 scrolling::encodeMessage();
+                 bench::doNotOptimize(scrolling::gMessageSegments);
+               });
+  }
+}
+
+void benchUpdateScrollBuffer() {
+  for (size_t length : kMessageLengths) {
+    const std::string message = sampleMessage(length);
+    scrolling::setMessage(message.data(), length);
+    bench::run("updateScrollBuffer/len_" + std::to_string(length),
+               scrolling::kDisplayDigits, [] {
+                 scrolling::gScrollIndex =
+                     (scrolling::gScrollIndex + 1) % scrolling::gScrollLimit;
+                 scrolling::updateScrollBuffer();
+                 bench::doNotOptimize(scrolling::gDisplayBuffer);
+               });
+  }
+}
+
+void benchBakedStrips() {
+  static const char kBanner[] = "HELLO 7SEG";
+  bench::run("setMessage/default_banner_text", sizeof(kBanner) - 1, [] {
+    scrolling::setMessage(kBanner, sizeof(kBanner) - 1);
+    bench::doNotOptimize(scrolling::gDisplayBuffer);
+  });
+  bench::run("showStrip/default_banner_baked", sizeof(kBanner) - 1, [] {
+    scrolling::showStrip(stripFromFlash(scrolling::kDefaultBanner));
+    bench::doNotOptimize(scrolling::gDisplayBuffer);
+  });
+}
+
+void benchIsPingCommand() {
+  static const char *const kInputs[][2] = {
+      {"exact", "PING"},
+      {"padded_direction", "  ping 9  "},
+      {"near_miss", "PINGS"},
+      {"other_text", "HELLO WORLD"},
+  };
+  for (const auto &input : kInputs) {
+    const char *text = input[1];
+    const size_t length = strlen(text);
+    bench::run(std::string("isPingCommand/") + input[0], length,
+               [text, length] {
+                 bench::doNotOptimize(scrolling::isPingCommand(text, length));
+               });
+  }
+
+  const std::string longest = sampleMessage(scrolling::kMaxMessageLength);
+  bench::run("isPingCommand/len_64", longest.size(), [&longest] {
+    bench::doNotOptimize(
+        scrolling::isPingCommand(longest.data(), longest.size()));
+  });
+}
+
+void benchTransitions() {
+  static const struct {
+    const char *name;
+    scrolling::TransitionEffect effect;
+  } kEffects[] = {
+      {"wipe", scrolling::TransitionEffect::Wipe},
+      {"dissolve", scrolling::TransitionEffect::Dissolve},
+      {"push_up", scrolling::TransitionEffect::PushUp},
+      {"dash_flip", scrolling::TransitionEffect::DashFlip},
+  };
+  static const char kOld[] = "OLD TEXT";
+  static const char kNew[] = "NEW TEXT";
+
+  for (const auto &entry : kEffects) {
+    const scrolling::TransitionEffect effect = entry.effect;
+    scrolling::transitionToMessage(kNew, sizeof(kNew) - 1, effect);
+    size_t frames = 0;
+    while (scrolling::gTransitionEffect != scrolling::TransitionEffect::Cut) {
+      scrolling::advanceTransition();
+      ++frames;
+    }
+
+    // One op runs a whole effect; the per-item figure is the scan-frame cost.
+    bench::run(std::string("advanceTransition/") + entry.name, frames,
+               [effect] {
+                 scrolling::transitionToMessage(kOld, sizeof(kOld) - 1, effect);
+                 while (scrolling::gTransitionEffect !=
+                        scrolling::TransitionEffect::Cut) {
+                   scrolling::advanceTransition();
+                 }
+                 bench::doNotOptimize(scrolling::gDisplayBuffer);
+               });
+  }
+}
+
+void benchSetPatternsForValue() {
+  for (bool inverted : {false, true}) {
+    bench::run(std::string("setPatternsForValue/sweep_0_9999") +
+                   (inverted ? "_inverted" : ""),
+               10000, [inverted] {
+                 for (int value = 0; value <= 9999; ++value) {
+                   counter::setPatternsForValue(value, inverted);
+                   bench::doNotOptimize(counter::activePatterns);
+                 }
+               });
+  }
+}
+
+// The tester copies its baked test patterns out of kTestPatterns; the old
+// glyphFor/* results show up in compare.py as only in base.
+void benchTestPatternMasks() {
+  const size_t cells =
+      tester::kPatternLength *
+      (sizeof(tester::kTestPatterns) / sizeof(tester::kTestPatterns[0]));
+  bench::run("testPatternMasks/baked", cells, [] {
+    for (const auto &pattern : tester::kTestPatterns) {
+      uint8_t masks[tester::kPatternLength];
+      memcpy_P(masks, pattern.cells, tester::kPatternLength);
+      bench::doNotOptimize(masks);
+    }
+  });
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const char *outputPath = (argc > 1) ? argv[1] : "bench_results.json";
+
+  benchEncodeChar();
+  benchEncodeMessage();
+  benchUpdateScrollBuffer();
+  benchBakedStrips();
+  benchIsPingCommand();
+  benchTransitions();
+  benchSetPatternsForValue();
+  benchTestPatternMasks();
+
+  if (!bench::writeJson(outputPath)) {
+    fprintf(stderr, "failed to write %s\n", outputPath);
+    return 1;
+  }
+  printf("wrote %s\n", outputPath);
+  return 0;
+}
@@ -0,0 +1,19 @@
+// Loop marker for the bench/avr simavr harness.
+//
+// Builds with -DBENCH_LOOP_MARKER (the megaatmega2560_sim envs) toggle
+// BENCH_LOOP_MARKER_PIN at the top of every loop() pass; the harness times
+// loop() from the edges on that pin. Other builds compile both macros away.
+//
+//   void setup() { BENCH_LOOP_SETUP(); ... }
+//   void loop() { BENCH_LOOP_MARK(); ... }
+#pragma once
+
+#define BENCH_LOOP_MARKER_PIN 42 // PL7 on the Mega 2560
+
+#ifdef BENCH_LOOP_MARKER
+#define BENCH_LOOP_SETUP() (DDRL |= _BV(PL7))
+#define BENCH_LOOP_MARK() (PORTL ^= _BV(PL7))
+#else
+#define BENCH_LOOP_SETUP() ((void)0)
+#define BENCH_LOOP_MARK() ((void)0)
+#endif
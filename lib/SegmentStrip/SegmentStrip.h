@@ -0,0 +1,161 @@
+// Compile-time baking of text into 7-segment cell strips.
+//
+// bakeSegments<Font>("TEXT") encodes a string literal with Font::segments()
+// while compiling, so a PROGMEM strip costs no encoding time and no SRAM:
+//
+//   struct MyFont {
+//     static constexpr uint8_t segments(char c) { ... }
+//   };
+//   constexpr auto kBanner PROGMEM = bakeSegments<MyFont>("HELLO");
+//   showStrip(stripFromFlash(kBanner));
+//
+// Written for C++11 constexpr rules (single-return functions) to match the
+// gnu++11 toolchain default.
+#pragma once
+
+#include <Arduino.h>
+
+template <size_t... Indices> struct IndexList {};
+
+template <size_t Count, size_t... Indices>
+struct MakeIndexList : MakeIndexList<Count - 1, Count - 1, Indices...> {};
+
+template <size_t... Indices> struct MakeIndexList<0, Indices...> {
+  typedef IndexList<Indices...> type;
+};
+
+// Encoded text plus visible-edge metadata. A cell counts as visible when its
+// character is not a space, even if the font cannot draw it;
+// firstVisible == length marks an all-blank strip. [gapStart, gapEnd) is the
+// widest run of spaces between two visible cells, empty when they are equal.
+template <size_t Length> struct SegmentStrip {
+  uint8_t cells[Length];
+  uint8_t length;
+  uint8_t firstVisible;
+  uint8_t lastVisible;
+  uint8_t gapStart;
+  uint8_t gapEnd;
+};
+
+// Lookup table indexed by character code.
+template <size_t Count> struct SegmentTable {
+  uint8_t cells[Count];
+};
+
+// Non-template handle on a strip, with cells either in flash or in SRAM.
+struct SegmentStripView {
+  const uint8_t *cells;
+  uint8_t length;
+  uint8_t firstVisible;
+  uint8_t lastVisible;
+  uint8_t gapStart;
+  uint8_t gapEnd;
+  bool inFlash;
+};
+
+// One entry of a compile-time glyph table.
+struct Glyph {
+  char symbol;
+  uint8_t mask;
+};
+
+// Mask of the first entry for symbol in table, 0 when there is none.
+template <size_t N>
+constexpr uint8_t glyphLookup(const Glyph (&table)[N], char symbol,
+                              size_t index = 0) {
+  return (index >= N) ? 0
+         : (table[index].symbol == symbol)
+             ? table[index].mask
+             : glyphLookup(table, symbol, index + 1);
+}
+
+// Font over a glyph table, looked up symbol for symbol:
+//
+//   constexpr Glyph kGlyphs[] = {{'0', 0x3F}, {'1', 0x06}};
+//   typedef GlyphFont<sizeof(kGlyphs) / sizeof(kGlyphs[0]), kGlyphs> MyFont;
+template <size_t N, const Glyph (&Table)[N]> struct GlyphFont {
+  static constexpr uint8_t segments(char symbol) {
+    return glyphLookup(Table, symbol);
+  }
+};
+
+template <size_t N>
+constexpr uint8_t firstVisibleCell(const char (&text)[N], size_t index) {
+  return (index >= N - 1 || text[index] != ' ')
+             ? static_cast<uint8_t>(index)
+             : firstVisibleCell(text, index + 1);
+}
+
+template <size_t N>
+constexpr uint8_t lastVisibleCell(const char (&text)[N], size_t end) {
+  return (end == 0) ? 0
+         : (text[end - 1] != ' ')
+             ? static_cast<uint8_t>(end - 1)
+             : lastVisibleCell(text, end - 1);
+}
+
+template <size_t N>
+constexpr uint8_t spaceRunEnd(const char (&text)[N], size_t index) {
+  return (index >= N - 1 || text[index] != ' ')
+             ? static_cast<uint8_t>(index)
+             : spaceRunEnd(text, index + 1);
+}
+
+// Start of the widest run of spaces between two visible cells, scanning from
+// index; best starts the widest run so far (a visible cell for none yet).
+template <size_t N>
+constexpr uint8_t widestGapStart(const char (&text)[N], size_t index,
+                                 size_t best) {
+  return (index >= N - 1) ? static_cast<uint8_t>(best)
+         : (text[index] != ' ') ? widestGapStart(text, index + 1, best)
+         : (spaceRunEnd(text, index) < N - 1 &&
+            spaceRunEnd(text, index) - index >
+                spaceRunEnd(text, best) - best)
+             ? widestGapStart(text, spaceRunEnd(text, index), index)
+             : widestGapStart(text, spaceRunEnd(text, index), best);
+}
+
+template <size_t N> constexpr uint8_t widestGapStart(const char (&text)[N]) {
+  return widestGapStart(text, firstVisibleCell(text, 0),
+                        firstVisibleCell(text, 0));
+}
+
+template <typename Font, size_t N, size_t... Indices>
+constexpr SegmentStrip<N - 1> bakeSegments(const char (&text)[N],
+                                           IndexList<Indices...>) {
+  return {{Font::segments(text[Indices])...},
+          static_cast<uint8_t>(N - 1),
+          firstVisibleCell(text, 0), lastVisibleCell(text, N - 1),
+          widestGapStart(text), spaceRunEnd(text, widestGapStart(text))};
+}
+
+template <typename Font, size_t N>
+constexpr SegmentStrip<N - 1> bakeSegments(const char (&text)[N]) {
+  static_assert(N > 1, "cannot bake an empty string");
+  static_assert(N <= 256, "baked strips hold at most 255 cells");
+  return bakeSegments<Font>(text, typename MakeIndexList<N - 1>::type());
+}
+
+template <typename Font, size_t... Codes>
+constexpr SegmentTable<sizeof...(Codes)> bakeSegmentTable(IndexList<Codes...>) {
+  return {{Font::segments(static_cast<char>(Codes))...}};
+}
+
+// Font::segments() for every character code below Count.
+template <typename Font, size_t Count>
+constexpr SegmentTable<Count> bakeSegmentTable() {
+  return bakeSegmentTable<Font>(typename MakeIndexList<Count>::type());
+}
+
+template <size_t Length>
+SegmentStripView stripFromFlash(const SegmentStrip<Length> &strip) {
+  return {strip.cells, pgm_read_byte(&strip.length),
+          pgm_read_byte(&strip.firstVisible),
+          pgm_read_byte(&strip.lastVisible), pgm_read_byte(&strip.gapStart),
+          pgm_read_byte(&strip.gapEnd), true};
+}
+
+inline uint8_t stripCell(const SegmentStripView &strip, size_t index) {
+  return strip.inFlash ? pgm_read_byte(&strip.cells[index])
+                       : strip.cells[index];
+}
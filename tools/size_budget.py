@@ -0,0 +1,53 @@
+# PlatformIO post-build script: fails the build when the firmware's static RAM
+# (.data + .bss + .noinit) or flash (.text + .data) use exceeds the
+# custom_ram_budget / custom_flash_budget options of the environment. Budgets
+# are in bytes; whatever SRAM static data leaves free, out of the Mega's 8 KB,
+# is what the stack gets.
+#
+#   extra_scripts = post:../tools/size_budget.py
+#   custom_ram_budget = 1536
+#   custom_flash_budget = 24576
+
+Import("env")  # noqa: F821 (provided by PlatformIO/SCons)
+
+import subprocess
+
+
+def section_sizes(size_output):
+    sizes = {}
+    for line in size_output.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0].startswith(".") and fields[1].isdigit():
+            sizes[fields[0]] = int(fields[1])
+    return sizes
+
+
+def project_budget(env, option):
+    value = env.GetProjectOption(option, "")
+    return int(value) if value else 0
+
+
+def check_size_budget(target, source, env):
+    elf_path = str(target[0])
+    output = subprocess.check_output(
+        [env.subst("$SIZETOOL"), "-A", elf_path]).decode()
+    sizes = section_sizes(output)
+    ram = sizes.get(".data", 0) + sizes.get(".bss", 0) + sizes.get(".noinit", 0)
+    flash = sizes.get(".text", 0) + sizes.get(".data", 0)
+
+    within_budget = True
+    for label, used, option in (("RAM", ram, "custom_ram_budget"),
+                                ("Flash", flash, "custom_flash_budget")):
+        budget = project_budget(env, option)
+        if budget <= 0:
+            continue
+        ok = used <= budget
+        within_budget = within_budget and ok
+        print("%s budget: %d of %d bytes (%d left)%s" % (
+            label, used, budget, budget - used,
+            "" if ok else " -- OVER BUDGET, raise %s deliberately" % option))
+
+    return 0 if within_budget else 1
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", check_size_budget)  # noqa: F821